@@ -0,0 +1,334 @@
+/****************************************************************************
+  FileName     [ cirAig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define compact AIG core functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include <queue>
+#include "cirAig.h"
+#include "cirGate.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define CIR_SIMD
+#endif
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+//o[w] = (a[w]^ma) & (b[w]^mb) for w < nw, ma/mb are 0 or ~0 (inverted)
+typedef void (*AndKernel)(size_t*, const size_t*, size_t, 
+	const size_t*, size_t, unsigned);
+
+static void
+andScalar(size_t *o, const size_t *a, size_t ma, 
+	const size_t *b, size_t mb, unsigned nw){
+	for(unsigned w=0;w<nw;w++) o[w] = (a[w]^ma) & (b[w]^mb);
+}
+#ifdef CIR_SIMD
+__attribute__((target("avx2"))) static void
+andAvx2(size_t *o, const size_t *a, size_t ma, 
+	const size_t *b, size_t mb, unsigned nw){
+	__m256i vma = _mm256_set1_epi64x(ma), vmb = _mm256_set1_epi64x(mb);
+	unsigned w=0;
+	for(;w+4<=nw;w+=4){
+		__m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a+w)),vma);
+		__m256i y = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(b+w)),vmb);
+		_mm256_storeu_si256((__m256i*)(o+w),_mm256_and_si256(x,y));
+	}
+	for(;w<nw;w++) o[w] = (a[w]^ma) & (b[w]^mb);
+}
+__attribute__((target("avx512f"))) static void
+andAvx512(size_t *o, const size_t *a, size_t ma, 
+	const size_t *b, size_t mb, unsigned nw){
+	__m512i vma = _mm512_set1_epi64(ma), vmb = _mm512_set1_epi64(mb);
+	unsigned w=0;
+	for(;w+8<=nw;w+=8){
+		__m512i x = _mm512_xor_si512(_mm512_loadu_si512((const void*)(a+w)),vma);
+		__m512i y = _mm512_xor_si512(_mm512_loadu_si512((const void*)(b+w)),vmb);
+		_mm512_storeu_si512((void*)(o+w),_mm512_and_si512(x,y));
+	}
+	for(;w<nw;w++) o[w] = (a[w]^ma) & (b[w]^mb);
+}
+#endif
+static AndKernel
+pickKernel(const char *&name){
+#ifdef CIR_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")){ name="avx512"; return andAvx512; }
+	if(__builtin_cpu_supports("avx2")){ name="avx2"; return andAvx2; }
+#endif
+	name="scalar";
+	return andScalar;
+}
+static const char *kernelStr = NULL;
+static AndKernel andKernel = pickKernel(kernelStr);
+
+//word evaluations a simulation pass needs before it is split over
+//threads, in total and per level (per thread) for the split by levels
+#define SIM_PAR_WORK (size_t(1)<<16)
+#define SIM_LVL_WORK (size_t(1)<<12)
+
+/**************************************/
+/*   class CirAig member functions    */
+/**************************************/
+//signatures and vars of surviving gates are kept, level is taken over
+void
+CirAig::build(const GateList &gateList, const GateList &dfsList,
+	vector<unsigned> &level)
+{
+	size_t n = gateList.size();
+	_fanin.assign(2*n,0);
+	_type.assign(n,UNDEF_GATE);
+	_sig.resize(n*_nWords,0);
+	_order.clear();
+	_order.reserve(dfsList.size());
+
+	for(size_t i=0;i<n;i++){
+		CirGate *g = gateList[i];
+		if(g==NULL) continue;
+		_type[i] = g->getType();
+		for(int j=0;j<g->FaninSize();j++)
+			_fanin[2*i+j] = g->getFaninGateID(j)*2 + g->getFaninGatePhase(j);
+	}
+	for(size_t i=0;i<dfsList.size();i++)
+		_order.push_back(dfsList[i]->getID());
+	_level.swap(level);
+	_level.resize(n,0);
+	_lvlDirty = true;
+	_active.clear(); _actValid = false;
+}
+//new dfs order after merges, levels follow the current fanins
+void
+CirAig::setOrder(const GateList &dfsList)
+{
+	_lvlDirty = true;
+	_active.clear(); _actValid = false;
+	_order.clear();
+	for(size_t i=0;i<dfsList.size();i++){
+		unsigned id = dfsList[i]->getID();
+		_order.push_back(id);
+		switch(_type[id]){
+			case AIG_GATE:
+				_level[id] = 1 + max(_level[_fanin[2*id]>>1],
+									 _level[_fanin[2*id+1]>>1]);
+				break;
+			case PO_GATE:
+				_level[id] = _level[_fanin[2*id]>>1];
+				break;
+			default:
+				_level[id] = 0;
+				break;
+		}
+	}
+}
+void
+CirAig::clear()
+{
+	_fanin.clear(); _type.clear();
+	_sig.clear(); _order.clear(); _level.clear();
+	_lvlGate.clear(); _lvlStart.clear(); _lvlDirty = true;
+	_active.clear(); _actGate.clear(); _actStart.clear();
+	_actValid = false; _actDirty = true;
+	_queued.clear();
+}
+//old words of a gate are kept as far as they fit
+void
+CirAig::setWords(unsigned nw)
+{
+	assert(nw>0);
+	if(nw==_nWords) return;
+	vector<size_t> sig(_type.size()*nw,0);
+	for(size_t i=0;i<_type.size();i++){
+		for(unsigned w=0;w<nw && w<_nWords;w++)
+			sig[i*nw+w] = _sig[i*_nWords+w];
+	}
+	_sig.swap(sig);
+	_nWords = nw;
+}
+const char*
+CirAig::kernelName()
+{
+	return kernelStr;
+}
+//words [w0,w0+nw) of one gate
+inline void
+CirAig::simGate(unsigned id, unsigned w0, unsigned nw, bool scalar)
+{
+	AndKernel kernel = (scalar ? andScalar : andKernel);
+	unsigned f0 = _fanin[2*id], f1 = _fanin[2*id+1];
+	size_t *s = &_sig[w0];
+	size_t *o = s + size_t(id)*_nWords;
+	switch(_type[id]){
+		case AIG_GATE:
+			kernel(o,s+size_t(f0>>1)*_nWords,(f0&1) ? ~size_t(0) : 0,
+				s+size_t(f1>>1)*_nWords,(f1&1) ? ~size_t(0) : 0,nw);
+			break;
+		case PO_GATE:
+			kernel(o,s+size_t(f0>>1)*_nWords,(f0&1) ? ~size_t(0) : 0,
+				s+size_t(f0>>1)*_nWords,(f0&1) ? ~size_t(0) : 0,nw);
+			break;
+		case UNDEF_GATE:
+			fill(o,o+nw,0);
+			break;
+		default:
+			break;
+	}
+}
+//event-driven update of word w: gate ids[i] gets words[i], only the
+//fanout cones of words that really changed are re-evaluated, in level
+//order. Levels must be current (setOrder after the last merge). Gates
+//whose word changed are appended to changed, POs excluded.
+void
+CirAig::resimulate(const CirFanout &fanout, const IdList &ids,
+	const vector<size_t> &words, IdList &changed, unsigned w)
+{
+	//key: level<<32 | id, smallest level first. A PO shares the level
+	//of its fanin, so it is queued one level later.
+	priority_queue<size_t,vector<size_t>,greater<size_t> > events;
+	_queued.resize(size(),0);
+	auto schedule = [&](unsigned id){
+		for(unsigned k=fanout.begin(id);k<fanout.end(id);k++){
+			if(fanout.dead(k)) continue;
+			unsigned fo = fanout.gate(k);
+			if(_queued[fo]) continue;
+			_queued[fo] = 1;
+			events.push((size_t(_level[fo]+(_type[fo]==PO_GATE))<<32) | fo);
+		}
+	};
+	for(size_t i=0;i<ids.size();i++){
+		unsigned id = ids[i];
+		if(sig(id,w)==words[i]) continue;
+		setSig(id,words[i],w);
+		changed.push_back(id);
+		schedule(id);
+	}
+	while(!events.empty()){
+		unsigned id = unsigned(events.top());
+		events.pop();
+		_queued[id] = 0;
+		size_t old = sig(id,w);
+		simGate(id,w,1,false);
+		if(sig(id,w)==old || _type[id]==PO_GATE) continue;
+		changed.push_back(id);
+		schedule(id);
+	}
+}
+//bucket the AIG gates of order by level (counting sort), POs go to one
+//last bucket
+void
+CirAig::buildLevels(const IdList &order, IdList &lvlGate,
+	vector<unsigned> &lvlStart)
+{
+	unsigned maxLv=0;
+	for(size_t i=0;i<order.size();i++)
+		maxLv = max(maxLv,_level[order[i]]);
+	//bucket L+1 holds level L, bucket maxLv+1 the POs
+	lvlStart.assign(maxLv+3,0);
+	for(size_t i=0;i<order.size();i++){
+		unsigned id = order[i];
+		if(_type[id]==AIG_GATE) lvlStart[_level[id]+1]++;
+		else if(_type[id]==PO_GATE) lvlStart[maxLv+2]++;
+	}
+	for(size_t l=1;l<lvlStart.size();l++) lvlStart[l]+=lvlStart[l-1];
+	lvlGate.resize(lvlStart.back());
+	vector<unsigned> pos(lvlStart.begin(),lvlStart.end()-1);
+	for(size_t i=0;i<order.size();i++){
+		unsigned id = order[i];
+		if(_type[id]==AIG_GATE) lvlGate[pos[_level[id]]++] = id;
+		else if(_type[id]==PO_GATE) lvlGate[pos[maxLv+1]++] = id;
+	}
+}
+//_order restricted to the transitive fanins of roots, still topological
+void
+CirAig::setActive(const IdList &roots)
+{
+	vector<char> mark(size(),0);
+	IdList stack(roots);
+	while(!stack.empty()){
+		unsigned id = stack.back();
+		stack.pop_back();
+		if(mark[id]) continue;
+		mark[id] = 1;
+		switch(_type[id]){
+			case AIG_GATE:
+				stack.push_back(_fanin[2*id+1]>>1); //fall through
+			case PO_GATE:
+				stack.push_back(_fanin[2*id]>>1);
+				break;
+			default:
+				break;
+		}
+	}
+	_active.clear();
+	for(size_t i=0;i<_order.size();i++)
+		if(mark[_order[i]]) _active.push_back(_order[i]);
+	_actValid = true; _actDirty = true;
+}
+//simulate the first nw words (all if 0) of every gate, 64 patterns per
+//word, PI signals must be set beforehand. With active only the gates of
+//the active sub-order are evaluated. With several threads, wide
+//signatures are split by words (no synchronization), narrow ones are
+//split level by level with a barrier between levels. Passes too small
+//to pay for the wake-ups, or with too few gates per level (deep
+//chains), stay on the calling thread.
+void
+CirAig::simulate(unsigned nw, int numThreads, bool scalar, bool active)
+{
+	if(nw==0 || nw>_nWords) nw = _nWords;
+	fill(_sig.begin(),_sig.begin()+nw,0);
+	active = active && _actValid;
+	const IdList &order = active ? _active : _order;
+	int T = max(numThreads,1);
+	size_t work = size_t(nw)*order.size();
+	if(work<SIM_PAR_WORK) T = 1;
+	if(T>1 && nw>=4*unsigned(T)){
+		parallelRun(T,[&](int t){
+			unsigned w0 = nw*t/T, w1 = nw*(t+1)/T;
+			for(size_t i=0;i<order.size();i++)
+				simGate(order[i],w0,w1-w0,scalar);
+		});
+		return;
+	}
+	if(T>1 && active && _actDirty){
+		buildLevels(_active,_actGate,_actStart);
+		_actDirty = false;
+	}
+	if(T>1 && !active && _lvlDirty){
+		buildLevels(_order,_lvlGate,_lvlStart);
+		_lvlDirty = false;
+	}
+	const IdList &lvlGate = active ? _actGate : _lvlGate;
+	const vector<unsigned> &lvlStart = active ? _actStart : _lvlStart;
+	if(T>1 && work < SIM_LVL_WORK*T*(lvlStart.size()-1)) T = 1;
+	if(T==1){
+		for(size_t i=0;i<order.size();i++)
+			simGate(order[i],0,nw,scalar);
+		return;
+	}
+	SpinBarrier barrier(T);
+	parallelRun(T,[&](int t){
+		for(size_t l=0;l+1<lvlStart.size();l++){
+			size_t s = lvlStart[l], n = lvlStart[l+1]-s;
+			for(size_t k=s+n*t/T;k<s+n*(t+1)/T;k++)
+				simGate(lvlGate[k],0,nw,scalar);
+			barrier.wait();
+		}
+	});
+}
+size_t
+CirAig::memUsage() const
+{
+	return _fanin.capacity()*sizeof(unsigned) + _type.capacity()
+		+ _sig.capacity()*sizeof(size_t)
+		+ _order.capacity()*sizeof(unsigned) + _level.capacity()*sizeof(unsigned)
+		+ (_lvlGate.capacity()+_lvlStart.capacity())*sizeof(unsigned)
+		+ (_active.capacity()+_actGate.capacity()+_actStart.capacity())
+			*sizeof(unsigned)
+		+ _queued.capacity();
+}
@@ -0,0 +1,95 @@
+/****************************************************************************
+  FileName     [ cirAig.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define compact struct-of-arrays AIG core ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_AIG_H
+#define CIR_AIG_H
+
+#include <vector>
+#include "cirDef.h"
+#include "cirFanout.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Flat arrays indexed by gate ID. A literal is 2*ID+phase as in AIGER.
+// The CirGate objects stay for netlist editing & reporting, the hot loops
+// (simulation, strash, optimize, fraig) read fanins and signatures from
+// here. Each gate has words() consecutive 64-bit signature words,
+// simulated by a kernel picked from the CPU at startup.
+class CirAig
+{
+public:
+   CirAig(): _nWords(1), _lvlDirty(true), _actValid(false), _actDirty(true) {}
+   ~CirAig() {}
+
+   void build(const GateList &gateList, const GateList &dfsList,
+		vector<unsigned> &level);
+   void clear();
+   size_t size() const { return _type.size(); }
+
+   //Gate type
+   GateType type(unsigned id) const { return GateType(_type[id]); }
+   void setType(unsigned id, GateType t) { _type[id] = t; }
+
+   //Fanin related, PO only uses fanin 0
+   unsigned fanin(unsigned id, int i) const { return _fanin[2*id+i]; }
+   void setFanin(unsigned id, int i, unsigned lit) { _fanin[2*id+i] = lit; }
+
+   //dfs order, as gate IDs, and logic level (AIG count on longest path)
+   const IdList& order() const { return _order; }
+   void setOrder(const GateList &dfsList);
+   unsigned level(unsigned id) const { return _level[id]; }
+
+   //Signal, word w of gate id
+   void setWords(unsigned nw);
+   unsigned words() const { return _nWords; }
+   size_t sig(unsigned id, unsigned w=0) const { return _sig[id*_nWords+w]; }
+   size_t litSig(unsigned lit, unsigned w=0) const { 
+	   return (lit&1) ? ~sig(lit>>1,w) : sig(lit>>1,w);
+   }
+   void setSig(unsigned id, size_t s, unsigned w=0) { _sig[id*_nWords+w] = s; }
+   void simulate(unsigned nw=0, int numThreads=1, bool scalar=false,
+		bool active=false);
+   void resimulate(const CirFanout &fanout, const IdList &ids, 
+		const vector<size_t> &words, IdList &changed, unsigned w=0);
+   static const char* kernelName();
+
+   //active sub-order: the fanin cones of roots, dropped by setOrder
+   void setActive(const IdList &roots);
+   void clearActive() { _active.clear(); _actValid = false; _actDirty = true; }
+   bool hasActive() const { return _actValid; }
+   size_t activeSize() const { return _active.size(); }
+
+   size_t memUsage() const;
+
+private:
+   void buildLevels(const IdList &order, IdList &lvlGate,
+		vector<unsigned> &lvlStart);
+   void simGate(unsigned id, unsigned w0, unsigned nw, bool scalar);
+
+   vector<unsigned>       _fanin; //2 literals per gate
+   vector<unsigned char>  _type;
+   vector<size_t>         _sig; //_nWords per gate
+   unsigned               _nWords;
+   IdList                 _order;
+   vector<unsigned>       _level;
+   //_order regrouped by level for parallel simulation, POs last
+   IdList                 _lvlGate;
+   vector<unsigned>       _lvlStart;
+   bool                   _lvlDirty;
+   //cone-restricted order and its level buckets
+   IdList                 _active;
+   IdList                 _actGate;
+   vector<unsigned>       _actStart;
+   bool                   _actValid, _actDirty;
+   vector<unsigned char>  _queued; //event queue membership
+};
+
+#endif // CIR_AIG_H
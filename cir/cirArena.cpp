@@ -0,0 +1,66 @@
+/****************************************************************************
+  FileName     [ cirArena.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define bump allocator functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include "cirArena.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static atomic<size_t> arenaGen(0);
+
+//per-thread allocation point, valid while gen matches the arena's
+struct ArenaCursor
+{
+	size_t gen;
+	char *cur, *end;
+};
+static thread_local ArenaCursor cursor = { 0, NULL, NULL };
+
+/**************************************/
+/*   class CirArena member functions  */
+/**************************************/
+CirArena::CirArena(): _bytes(0), _gen(++arenaGen) {}
+
+void*
+CirArena::alloc(size_t n)
+{
+	n = (n + alignof(max_align_t)-1) & ~(alignof(max_align_t)-1);
+	if(cursor.gen!=_gen || cursor.cur+n > cursor.end)
+		refill(n);
+	void *p = cursor.cur;
+	cursor.cur += n;
+	return p;
+}
+void
+CirArena::refill(size_t n)
+{
+	size_t size = (n>ARENA_BLOCK ? n : ARENA_BLOCK);
+	char *blk = (char*)malloc(size);
+	if(blk==NULL) throw bad_alloc();
+	{
+		lock_guard<mutex> lock(_mtx);
+		_blocks.push_back(blk);
+		_bytes += size;
+	}
+	cursor.gen = _gen;
+	cursor.cur = blk; cursor.end = blk+size;
+}
+void
+CirArena::reset()
+{
+	for(size_t i=0;i<_blocks.size();i++)
+		free(_blocks[i]);
+	_blocks.clear();
+	_bytes = 0;
+	_gen = ++arenaGen;
+}
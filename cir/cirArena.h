@@ -0,0 +1,51 @@
+/****************************************************************************
+  FileName     [ cirArena.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define bump allocator for gates and edges ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_ARENA_H
+#define CIR_ARENA_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Memory is handed out from large blocks and is only given back by
+// reset(), which frees every block at once. alloc() is thread-safe: each
+// thread bumps a pointer in its own block, the lock is only taken to get
+// a new block. Objects placed here must be destroyed explicitly.
+class CirArena
+{
+public:
+   CirArena();
+   ~CirArena() { reset(); }
+
+   void* alloc(size_t n);
+   void reset();
+
+   size_t numBlocks() const { return _blocks.size(); }
+   size_t numBytes() const { return _bytes; }
+
+private:
+   void refill(size_t n);
+
+   #define ARENA_BLOCK (size_t(1)<<20)
+   mutex          _mtx;
+   vector<char*>  _blocks;
+   size_t         _bytes;
+   size_t         _gen; //unique per arena lifetime, invalidates thread cursors
+};
+
+//placement form: new (arena) T(...)
+inline void* operator new(size_t n, CirArena &a) { return a.alloc(n); }
+inline void operator delete(void*, CirArena&) {}
+
+#endif // CIR_ARENA_H
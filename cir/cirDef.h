@@ -10,7 +10,10 @@
 #define CIR_DEF_H
 
 #include <vector>
+#include <thread>
+#include <atomic>
 #include "myHashMap.h"
+#include "cirPool.h"
 
 
 using namespace std;
@@ -33,4 +36,59 @@ enum GateType
 	TOT_GATE
 };
 
+//run job(0), ..., job(T-1) concurrently, the calling thread takes job(0)
+//and the others run on the persistent CirPool workers
+template<class Job> inline void
+parallelRun(int T, const Job &job)
+{
+	if(T<=1){ job(0); return; }
+	CirPool::instance().run(T,[&job](int t){ job(t); });
+}
+
+//xorshift64* generator, all 64 bits of a word are random
+class SimRng
+{
+public:
+	SimRng(size_t s=0) { seed(s); }
+	void seed(size_t s) { _s = s ? s : 0x9E3779B97F4A7C15ULL; }
+	size_t operator()(){
+		_s ^= _s>>12; _s ^= _s<<25; _s ^= _s>>27;
+		return _s*0x2545F4914F6CDD1DULL;
+	}
+private:
+	size_t _s;
+};
+
+//in-place 64x64 bit transpose: bit c of a[r] <-> bit r of a[c]
+inline void
+transpose64(size_t *a)
+{
+	size_t m = 0x00000000FFFFFFFFULL;
+	for(unsigned j=32;j!=0;j>>=1, m^=(m<<j)){
+		for(unsigned k=0;k<64;k=((k|j)+1)&~j){
+			size_t t = ((a[k]>>j) ^ a[k|j]) & m;
+			a[k] ^= t<<j; a[k|j] ^= t;
+		}
+	}
+}
+
+//reusable barrier for a fixed number of threads, waiting threads spin
+class SpinBarrier
+{
+public:
+	SpinBarrier(int n): _n(n), _count(0), _gen(0) {}
+	void wait(){
+		unsigned gen = _gen.load();
+		if(_count.fetch_add(1)+1 == _n){
+			_count.store(0);
+			_gen.fetch_add(1);
+		}
+		else while(_gen.load()==gen) this_thread::yield();
+	}
+private:
+	int              _n;
+	atomic<int>      _count;
+	atomic<unsigned> _gen;
+};
+
 #endif // CIR_DEF_H
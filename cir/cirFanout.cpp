@@ -0,0 +1,171 @@
+/****************************************************************************
+  FileName     [ cirFanout.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define CSR fanout index functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "cirFanout.h"
+#include "cirGate.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static inline unsigned
+encodeEdge(unsigned fo, int slot, bool phase){
+	return (fo<<2) | (unsigned(slot)<<1) | unsigned(phase);
+}
+
+/**************************************/
+/*   class CirFanout member functions */
+/**************************************/
+void
+CirFanout::resize(size_t n)
+{
+	_start.assign(n,0); _len.assign(n,0);
+	_cap.assign(n,0); _live.assign(n,0);
+	_pos.assign(2*n,DEAD_EDGE);
+	_edge.clear(); _dead=0;
+}
+void
+CirFanout::clear()
+{
+	_start.clear(); _len.clear(); _cap.clear(); _live.clear();
+	_pos.clear(); _edge.clear(); _dead=0;
+}
+//Rows are filled in (fanout ID, slot) order, same order as connect().
+//Sources are split in chunks, each chunk drops its edges in one bucket
+//per target chunk, then every target chunk fills its own rows.
+void
+CirFanout::build(const GateList &gateList, int numThreads)
+{
+	size_t n = gateList.size();
+	int T = max(1,numThreads);
+	if(n < size_t(T)*1024) T = 1;
+	resize(n);
+	#define CHUNK_BGN(t) (n*(t)/T)
+	#define CHUNK_OF(id) (min(size_t(T-1),size_t(id)*T/n))
+
+	struct Edge{ unsigned to, code; };
+	vector< vector< vector<Edge> > > bucket(T,vector< vector<Edge> >(T));
+	parallelRun(T,[&](int t){
+		for(size_t i=CHUNK_BGN(t);i<CHUNK_BGN(t+1);i++){
+			CirGate *g = gateList[i];
+			if(g==NULL) continue;
+			for(int j=0;j<g->FaninSize();j++){
+				unsigned to = g->getFaninGateID(j);
+				Edge e = { to, encodeEdge(i,j,g->getFaninGatePhase(j)) };
+				bucket[t][CHUNK_OF(to)].push_back(e);
+			}
+		}
+	});
+	//row sizes, then the start of each target chunk
+	vector<size_t> total(T+1,0);
+	parallelRun(T,[&](int p){
+		for(int t=0;t<T;t++){
+			for(size_t k=0;k<bucket[t][p].size();k++){
+				_len[bucket[t][p][k].to]++;
+				total[p+1]++;
+			}
+		}
+	});
+	for(int p=0;p<T;p++) total[p+1]+=total[p];
+	_edge.resize(total[T]);
+	parallelRun(T,[&](int p){
+		unsigned s = total[p];
+		for(size_t i=CHUNK_BGN(p);i<CHUNK_BGN(p+1);i++){
+			_start[i]=s; _cap[i]=_live[i]=_len[i];
+			s+=_len[i]; _len[i]=0;
+		}
+		for(int t=0;t<T;t++){
+			for(size_t k=0;k<bucket[t][p].size();k++){
+				Edge &e = bucket[t][p][k];
+				unsigned pos = _start[e.to] + _len[e.to]++;
+				_edge[pos] = e.code;
+				_pos[e.code>>1] = pos;
+			}
+		}
+	});
+	#undef CHUNK_BGN
+	#undef CHUNK_OF
+}
+//drop tombstones, order of live edges is kept
+void
+CirFanout::compact()
+{
+	vector<unsigned> edge;
+	edge.reserve(_edge.size()-_dead);
+	for(size_t i=0;i<_start.size();i++){
+		unsigned s = edge.size();
+		for(unsigned k=begin(i);k<end(i);k++){
+			if(dead(k)) continue;
+			_pos[_edge[k]>>1] = edge.size();
+			edge.push_back(_edge[k]);
+		}
+		_start[i]=s;
+		_len[i]=_cap[i]=edge.size()-s;
+		assert(_len[i]==_live[i]);
+	}
+	_edge.swap(edge);
+	_dead=0;
+}
+void
+CirFanout::add(unsigned id, unsigned fo, int slot, bool phase)
+{
+	if(id>=_start.size()){
+		size_t n = max(size_t(id),size_t(fo))+1;
+		_start.resize(n,0); _len.resize(n,0); _cap.resize(n,0); _live.resize(n,0);
+		_pos.resize(2*n,DEAD_EDGE);
+	}
+	if(_len[id]==_cap[id]){
+		//move row to the tail with twice the room, dead edges left behind
+		unsigned s = _edge.size();
+		unsigned cap = max(2U,2*_live[id]);
+		_edge.resize(s+cap,DEAD_EDGE);
+		unsigned len=0;
+		for(unsigned k=begin(id);k<end(id);k++){
+			if(dead(k)) continue;
+			_pos[_edge[k]>>1] = s+len;
+			_edge[s+len++] = _edge[k];
+		}
+		//tombstones of the old row are counted already
+		_dead += _cap[id]-(_len[id]-_live[id]);
+		_start[id]=s; _len[id]=len; _cap[id]=cap;
+	}
+	unsigned code = encodeEdge(fo,slot,phase);
+	unsigned pos = _start[id] + _len[id]++;
+	_edge[pos] = code;
+	_pos[code>>1] = pos;
+	_live[id]++;
+}
+void
+CirFanout::remove(unsigned id, unsigned fo, int slot)
+{
+	unsigned pos = _pos[2*fo+slot];
+	if(pos==DEAD_EDGE) return;
+	assert(pos>=begin(id) && pos<end(id));
+	_edge[pos] = DEAD_EDGE;
+	_pos[2*fo+slot] = DEAD_EDGE;
+	_live[id]--; _dead++;
+}
+//the fanin slots of the row are expected to be redirected already,
+//so their back-pointers are left alone
+void
+CirFanout::clearRow(unsigned id)
+{
+	for(unsigned k=begin(id);k<end(id);k++)
+		_edge[k] = DEAD_EDGE;
+	_dead += _live[id];
+	_live[id]=0;
+}
+size_t
+CirFanout::memUsage() const
+{
+	return (_start.capacity()+_len.capacity()+_cap.capacity()
+		+_live.capacity()+_edge.capacity()+_pos.capacity())*sizeof(unsigned);
+}
@@ -0,0 +1,63 @@
+/****************************************************************************
+  FileName     [ cirFanout.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define CSR fanout index ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_FANOUT_H
+#define CIR_FANOUT_H
+
+#include <vector>
+#include "cirDef.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Fanouts of all gates in compressed sparse rows. Row of gate "id" is
+// _edge[begin(id)..end(id)), an edge is (fanout ID, fanin slot, phase).
+// Removed edges are tombstoned through the back-pointer kept for every
+// fanin slot, so remove() is O(1) and the order of the remaining edges
+// is unchanged. add() appends to a row, moving the row to the tail of
+// _edge when it is full. compact() drops tombstones in bulk.
+class CirFanout
+{
+public:
+   #define DEAD_EDGE (~0U)
+   CirFanout(): _dead(0) {}
+   ~CirFanout() {}
+
+   void build(const GateList &gateList, int numThreads=1);
+   void compact();
+   void clear();
+
+   //Row access, dead edges have to be skipped while iterating
+   size_t size(unsigned id) const { return id<_live.size() ? _live[id] : 0; }
+   unsigned begin(unsigned id) const { return _start[id]; }
+   unsigned end(unsigned id) const { return _start[id]+_len[id]; }
+   bool dead(unsigned k) const { return _edge[k]==DEAD_EDGE; }
+   unsigned gate(unsigned k) const { return _edge[k]>>2; }
+   int slot(unsigned k) const { return (_edge[k]>>1)&1; }
+   bool isInv(unsigned k) const { return _edge[k]&1; }
+
+   //Edge update
+   void add(unsigned id, unsigned fo, int slot, bool phase);
+   void remove(unsigned id, unsigned fo, int slot);
+   void clearRow(unsigned id);
+   bool needCompact() const { return _dead > 1024 && _dead*2 > _edge.size(); }
+
+   size_t memUsage() const;
+
+private:
+   void resize(size_t n);
+
+   vector<unsigned> _start, _len, _cap, _live; //per gate
+   vector<unsigned> _edge;
+   vector<unsigned> _pos;  //fanin slot 2*fo+slot -> index in _edge
+   size_t           _dead; //tombstones + abandoned row space
+};
+
+#endif // CIR_FANOUT_H
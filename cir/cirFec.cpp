@@ -0,0 +1,115 @@
+/****************************************************************************
+  FileName     [ cirFec.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define partition-refinement FEC group functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include "cirFec.h"
+
+using namespace std;
+
+/**************************************/
+/*   class CirFec member functions    */
+/**************************************/
+void
+CirFec::init(const IdList &lits)
+{
+	clear();
+	if(lits.size()<2) return;
+	_lit = lits;
+	_beg.push_back(0); _end.push_back(lits.size());
+	_live = lits.size();
+}
+void
+CirFec::clear()
+{
+	_lit.clear(); _beg.clear(); _end.clear();
+	_phased = false; _live = 0;
+}
+bool
+CirFec::refine(const CirAig &aig, unsigned w, const vector<char> *mark)
+{
+	if(!_phased) mark = NULL;
+	bool split=false;
+	size_t n=0;
+	_nBeg.clear(); _nEnd.clear();
+	for(size_t g=0;g<_beg.size();g++){
+		unsigned b=_beg[g], e=_end[g];
+		bool touched = (mark==NULL);
+		for(unsigned k=b;k<e && !touched;k++)
+			touched = (*mark)[_lit[k]/2];
+		if(!touched){ _beg[n]=b; _end[n]=e; n++; continue; }
+		//phase-corrected signatures, split only if they differ
+		_key.clear();
+		bool same=true;
+		for(unsigned k=b;k<e;k++){
+			unsigned l = _lit[k];
+			if(!_phased){
+				l = (l & ~1U) | unsigned(aig.sig(l/2,w)>>63);
+				_lit[k] = l;
+			}
+			_key.push_back(make_pair(aig.litSig(l,w),l));
+			same = same && _key.back().first==_key[0].first;
+		}
+		if(same){ _beg[n]=b; _end[n]=e; n++; continue; }
+		split = true;
+		sort(_key.begin(),_key.end());
+		bool first=true;
+		for(unsigned i=0;i<_key.size();){
+			unsigned j=i;
+			for(;j<_key.size() && _key[j].first==_key[i].first;j++)
+				_lit[b+j] = _key[j].second;
+			if(j-i<2) _live -= j-i; //singleton
+			else if(first){ _beg[n]=b+i; _end[n]=b+j; n++; first=false; }
+			else { _nBeg.push_back(b+i); _nEnd.push_back(b+j); }
+			i=j;
+		}
+	}
+	_phased = true;
+	//new parts go after the surviving groups
+	_beg.resize(n); _end.resize(n);
+	_beg.insert(_beg.end(),_nBeg.begin(),_nBeg.end());
+	_end.insert(_end.end(),_nEnd.begin(),_nEnd.end());
+	compact();
+	return split;
+}
+void
+CirFec::sortGroups()
+{
+	vector<unsigned> order(_beg.size());
+	for(size_t g=0;g<order.size();g++) order[g]=g;
+	sort(order.begin(),order.end(),[this](unsigned a, unsigned b){
+		if(grpSize(a)!=grpSize(b)) return grpSize(a)<grpSize(b);
+		return lit(a,0)/2 < lit(b,0)/2;
+	});
+	vector<unsigned> beg(order.size()), end(order.size());
+	for(size_t g=0;g<order.size();g++){
+		beg[g]=_beg[order[g]]; end[g]=_end[order[g]];
+	}
+	_beg.swap(beg); _end.swap(end);
+}
+//rewrite _lit with the live groups only, once most of it is dead
+void
+CirFec::compact()
+{
+	if(_lit.size()<1024 || 2*_live>=_lit.size()) return;
+	vector<unsigned> lit;
+	lit.reserve(_live);
+	for(size_t g=0;g<_beg.size();g++){
+		unsigned b = lit.size();
+		lit.insert(lit.end(),_lit.begin()+_beg[g],_lit.begin()+_end[g]);
+		_beg[g]=b; _end[g]=lit.size();
+	}
+	assert(lit.size()==_live);
+	_lit.swap(lit);
+}
+size_t
+CirFec::memUsage() const
+{
+	return (_lit.capacity()+_beg.capacity()+_end.capacity()
+		+_nBeg.capacity()+_nEnd.capacity())*sizeof(unsigned)
+		+_key.capacity()*sizeof(pair<size_t,unsigned>);
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+  FileName     [ cirFec.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define partition-refinement FEC groups ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_FEC_H
+#define CIR_FEC_H
+
+#include <vector>
+#include <algorithm>
+#include "cirDef.h"
+#include "cirAig.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// FEC groups as ranges of one literal array, _lit[_beg[g].._end[g]).
+// A literal is 2*ID+phase; the phase is the value of the gate on the
+// first pattern of the first refinement, so members of a group have equal
+// phase-corrected signatures. refine() sorts a group by that signature
+// and cuts it in place; parts of 2 or more literals are kept as groups.
+// Dropped literals stay in _lit until the live ones are compacted.
+class CirFec
+{
+public:
+   CirFec(): _phased(false), _live(0) {}
+   ~CirFec() {}
+
+   void init(const IdList &lits);
+   void clear();
+
+   //Group access
+   size_t size() const { return _beg.size(); }
+   bool empty() const { return _beg.empty(); }
+   unsigned grpSize(size_t g) const { return _end[g]-_beg[g]; }
+   size_t numLits() const { return _live; }
+   unsigned lit(size_t g, unsigned j) const { return _lit[_beg[g]+j]; }
+
+   //split every group (or every group with a member marked) by word w of
+   //the signatures, true if any group splits
+   bool refine(const CirAig &aig, unsigned w=0,
+		const vector<char> *mark=NULL);
+
+   //drop literals for which keep(lit) is false, and groups left with
+   //less than 2 literals
+   template<class Keep> void filter(const Keep &keep){
+	   size_t n=0;
+	   for(size_t g=0;g<_beg.size();g++){
+		   unsigned b=_beg[g], e=b;
+		   for(unsigned k=_beg[g];k<_end[g];k++)
+			   if(keep(_lit[k])) _lit[e++]=_lit[k];
+		   _live -= _end[g]-e;
+		   if(e-b<2){ _live -= e-b; continue; }
+		   _beg[n]=b; _end[n]=e; n++;
+	   }
+	   _beg.resize(n); _end.resize(n);
+	   compact();
+   }
+   //order the literals of each group by less
+   template<class Less> void sortLits(const Less &less){
+	   for(size_t g=0;g<_beg.size();g++)
+		   sort(_lit.begin()+_beg[g],_lit.begin()+_end[g],less);
+   }
+   //order the groups by size, then by first literal
+   void sortGroups();
+
+   size_t memUsage() const;
+
+private:
+   void compact();
+
+   vector<unsigned>       _lit;
+   vector<unsigned>       _beg, _end;
+   bool                   _phased; //phases set by the 1st refinement
+   size_t                 _live;   //literals inside groups
+   //scratch for refine()
+   vector<pair<size_t,unsigned> > _key;
+   vector<unsigned>       _nBeg, _nEnd;
+};
+
+#endif // CIR_FEC_H
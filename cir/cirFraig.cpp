@@ -13,6 +13,9 @@
 #include "myHashMap.h"
 #include "util.h"
 #include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 using namespace std;
 
 /*******************************/
@@ -29,19 +32,23 @@ using namespace std;
 // _floatList may be changed.
 // _unusedList and _undefList won't be changed
 
-#define NUMSIG 5
+//expanded counterexamples (words) resimulated together at least
+#define CEX_EXPAND_BATCH 8
+//provers per fraig thread, the slots the threads balance over
+#define FRAIG_SLOTS 4
 
 void
 CirMgr::strash()
 {
 	unordered_map<size_t,CirGate*>Strash;
 	size_t f0,f1; size_t key;
-	for(int i=0;i<_dfsList.size();++i){
-		CirGate* gate = _dfsList[i];
+	const IdList &order = _aig.order();
+	for(int i=0;i<order.size();++i){
+		CirGate* gate = _gateList[order[i]];
 		CirGate* merGate;
-		if(gate->getType()==AIG_GATE){
-			f0 = gate->getFaninGateID(0)*2 + gate->getFaninGatePhase(0);
-			f1 = gate->getFaninGateID(1)*2 + gate->getFaninGatePhase(1);
+		if(_aig.type(order[i])==AIG_GATE){
+			f0 = _aig.fanin(order[i],0);
+			f1 = _aig.fanin(order[i],1);
 			if(f0>=f1) key = (f0<<32)+f1; //<< precedence lower than +
 			else key = (f1<<32)+f0; //<<precedence lower than +
 		}
@@ -52,159 +59,274 @@ CirMgr::strash()
 			cout<<"Strashing: ";
 			mergeGate(gate,merGate);
 		}
-		else Strash[key]=_dfsList[i];
+		else Strash[key]=gate;
 	}
 	resetFloat();
-	resetDfs();
+	updateDfs();
 	resetUnuse();
 	resetFEC();
 }
 
+//every member of a group is proven against the group's representative,
+//CONST0 if it is in the group, else its first member in DFS order,
+//which survives all merges; a disproved member leaves the group at the
+//next resimulation. So SAT calls are linear in the group size. Pairs
+//are taken in group order and proven in rounds of up to 8*_fraigThreads
+//pairs. With several threads there are FRAIG_SLOTS provers per thread
+//and pair q of a round goes to prover q%S (S slots in the round); the
+//threads pull whole slots from an atomic counter, so a slow pair holds
+//up only its slot while the other slots go to idle threads. Each prover sees the same sequence of pairs for a
+//fixed thread count, whichever thread runs it. Results are committed in
+//pair order by this thread only: merges, and counterexamples until they
+//are resimulated.
+//Counterexamples are resimulated when a batch of 64*words (words when
+//expanded) is full, or once the SAT time spent on disproved pairs since
+//the last resimulation, scaled by the candidates the last one removed
+//per counterexample, pays for a simulation pass.
+//Pairs over the cone budget are undecided and retried by another pass
+//with 4x the budget. SatSolver has no conflict limit, so a single SAT
+//call is not bounded; once the time budget is spent no more pairs are
+//started, not even those left in the round, and the pairs left are
+//reported undecided.
+//With a proof cache, pairs too large for exhaustive simulation are looked
+//up before SAT, and the decided ones are added to it.
 void
 CirMgr::fraig()
 {
-	SatSolver solver;
-	solver.initialize();
-	genProofModel(solver);
+	chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	int T = _fraigThreads;
+	int P = (T==1 ? 1 : FRAIG_SLOTS*T);
+	vector<CirProver> provers(P);
+	for(int t=0;t<P;t++) provers[t].reset(_aig);
+	IdList pis;
+	for(int i=0;i<_piList.size();i++) pis.push_back(_piList[i]->getID());
+	vector<int> piIdx(_aig.size(),-1);
+	for(size_t i=0;i<pis.size();i++) piIdx[pis[i]] = i;
+	bool useCache = _proofCache.enabled();
 	
+	//an expanded counterexample fills a whole word
+	int batch = _cexExpand ? max(int(_aig.words()),CEX_EXPAND_BATCH)
+		: 64*int(_aig.words());
 	int numSig=0;  
-	bool result; 
-	int id0,id1; bool ph0,ph1;
-	bool finished=false;
+	double satWaste=0, simCost=0, yield=1;
+	size_t round = (T==1 ? 1 : 8*size_t(T));
+	vector<FraigPair> pairs;
+	size_t gi=0; unsigned gk=1; //next pair: member gk of group gi
+	size_t budget = _pairBudget;
+	chrono::steady_clock::time_point end = t0 +
+		chrono::duration_cast<chrono::steady_clock::duration>(
+			chrono::duration<double>(_timeBudget));
+	bool undecided=false; //in this pass
+	_sigList.clear();
+	_cexRounds=0; _cacheLookups=0; _cacheHits=0;
+	_fraigProven=0; _fraigDisproven=0;
 	SortFEC(true);	
+	//word 0 has to be current, later rounds only resimulate the changes
+	if(!_fec.empty()){
+		chrono::steady_clock::time_point s0 = chrono::steady_clock::now();
+		simulate(1);
+		simCost = chrono::duration<double>(chrono::steady_clock::now()-s0).count();
+	}
 	while(true){
-	//1.Simulation
-		if(numSig==NUMSIG){ 
-			resetDfs();
-			resetFEC();
-			assert(_sigList.size()==_piList.size());		
-			for(int i=0;i<_sigList.size();i++){
-				for(int j=numSig;j<64;j++){
-					size_t bit = rnGen(2);
-					while(bit==2) bit = rnGen(2);
-					_sigList[i] = (_sigList[i]<<1)+ (size_t)(bit);
-				}
-			}
-			for(int i=0;i<_piList.size();i++)
-				_piList[i]->setSignal(_sigList[i]);
-			simulate();
-			if(_simLog!=NULL) writeSim(numSig);
-			bool change = IdentifyFEC();
-			SortFEC(true);
+		pairs.clear();
+		for(;gi<_fec.size() && pairs.size()<round;gk++){
+			if(gk>=_fec.grpSize(gi)){ gi++; gk=0; continue; }
+			FraigPair p = FraigPair();
+			p.id0 = _fec.lit(gi,0)/2; p.ph0 = _fec.lit(gi,0)%2;
+			p.id1 = _fec.lit(gi,gk)/2; p.ph1 = _fec.lit(gi,gk)%2;
+			if(_gateList[p.id0]!=NULL && _gateList[p.id1]!=NULL)
+				pairs.push_back(p);
 		}
-	
-	//2.Call SAT engine to prove FEC pair
-		numSig=0; 
-		_sigList.clear(); finished=false;
-		for(int i=0;i<_fecGrps.size();i++){
-			FECgroup *grp = _fecGrps[i];
-			for(int j=0;j<grp->size();j++){
-				for(int k=j+1;k<grp->size();k++){
-					if(i==_fecGrps.size()-1 && j==grp->size()-2 
-					   && k == grp->size()-1) 
-						finished = true;
-					
-					id0 = grp->at(j)/2; ph0 = grp->at(j)%2;
-					id1 = grp->at(k)/2; ph1 = grp->at(k)%2;
-					if(_gateList[id0]!=NULL && _gateList[id1]!=NULL){
-						result = ProvePair(solver,id0,ph0,id1,ph1);
-						//UNSAT
-						if(!result){
-							cout<<"Fraig: ";
-							mergeGate(_gateList[id1],_gateList[id0],ph0!=ph1); 
+		double sec = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+		if(_timeBudget>0 && sec>_timeBudget) break;
+		if(pairs.empty()){
+			if(!undecided) break;
+			//retry the undecided pairs with a larger budget
+			budget*=4; undecided=false;
+		}
+		else {
+			chrono::steady_clock::time_point s0 = chrono::steady_clock::now();
+			int S = min(P,int(pairs.size()));
+			atomic<int> slot(0);
+			parallelRun(min(T,S),[&](int){
+				for(int t=slot++;t<S;t=slot++)
+					for(size_t q=t;q<pairs.size();q+=S){
+						FraigPair &p = pairs[q];
+						if(_timeBudget>0 && chrono::steady_clock::now()>end){
+							p.res = PROOF_UNDECIDED;
+							continue;
 						}
-						else{
-							collectPattern(solver,numSig);
-							numSig++;
-							if(numSig==NUMSIG) break;
+						if(useCache){
+							p.key = provers[t].coneKey(_aig,p.id0,p.ph0,p.id1,p.ph1,
+								p.supp);
+							p.cached = p.supp.size()>SIM_SUPPORT &&
+								_proofCache.find(p.key,p.supp,piIdx,pis.size(),p.res,p.cex);
+							if(p.cached) continue;
 						}
+						p.res = provers[t].prove(_aig,p.id0,p.ph0,p.id1,p.ph1,
+							budget);
+						if(p.res==PROOF_NEQ)
+							provers[t].getCex(_aig,p.id0,p.id1,pis,p.cex);
 					}
-				}//end of for k
-				if(numSig==NUMSIG) break;
-			}//end of for j
-			if(numSig==NUMSIG) break;
-		}//end of for i, prove finished
-		if( (numSig==NUMSIG) && !finished) continue;
-		break;
-	}//end of while
+			});
+			double satSec = chrono::duration<double>(chrono::steady_clock::now()-s0).count();
+			for(size_t q=0;q<pairs.size();q++){
+				const FraigPair &p = pairs[q];
+				if(p.res==PROOF_UNDECIDED){ undecided=true; continue; }
+				if(p.res==PROOF_EQ) _fraigProven++;
+				else _fraigDisproven++;
+				if(useCache && p.supp.size()>SIM_SUPPORT){
+					_cacheLookups++;
+					if(p.cached) _cacheHits++;
+					else _proofCache.insert(p.key,p.supp,piIdx,p.res,p.cex);
+				}
+				//a pair is still a valid counterexample after merges
+				if(p.res==PROOF_NEQ){
+					satWaste += satSec/pairs.size();
+					if(numSig<batch) collectPattern(numSig++,p.cex);
+					continue;
+				}
+				if(_gateList[p.id0]==NULL || _gateList[p.id1]==NULL) continue;
+				for(int t=0;t<P;t++) provers[t].merged(p.id1);
+				cout<<"Fraig: ";
+				mergeGate(_gateList[p.id1],_gateList[p.id0],p.ph0!=p.ph1); 
+			}
+			if(numSig<batch && (numSig==0 || satWaste*yield<simCost)) continue;
+		}
+		//1.Simulation, worth it now or a new pass starts
+		if(numSig>0){
+			chrono::steady_clock::time_point s0 = chrono::steady_clock::now();
+			updateDfs();
+			resetFEC();
+			size_t cand = _fec.numLits()-_fec.size();
+			resimCex(numSig);
+			SortFEC(true);
+			simCost = chrono::duration<double>(chrono::steady_clock::now()-s0).count();
+			yield = max(1.0,double(cand-(_fec.numLits()-_fec.size()))/numSig);
+			numSig=0; _sigList.clear(); satWaste=0;
+		}
+		gi=0; gk=1;
+	}
 
 	resetFloat();
-	resetDfs();
+	updateDfs();
 	resetUnuse();
 	resetFEC();
 	
 	if(numSig>0){
-		assert(_sigList.size()==_piList.size());
-		for(int i=0;i<_piList.size();i++)
-			_piList[i]->setSignal(_sigList[i]);
-		simulate();
-		if(_simLog!=NULL) writeSim(64);
-		IdentifyFEC();
+		resimCex(numSig);
 		SortFEC(false);
 	}
+	_fraigUndecided = _fec.numLits()-_fec.size();
+	_log.flush();
+	if(!_proofCache.save())
+		cerr<<"Error: cannot write the proof cache!!"<<endl;
+	_satCalls=0; _satCex=0; _satRebuilds=0; _cnfVars=0; _cnfGates=0;
+	_simCalls=0; _simCex=0;
+	for(int t=0;t<P;t++){
+		_satCalls += provers[t].calls(); _satCex += provers[t].satCalls();
+		_satRebuilds += provers[t].rebuilds();
+		_simCalls += provers[t].simCalls(); _simCex += provers[t].simCex();
+		_cnfVars += provers[t].vars(); _cnfGates += provers[t].gates();
+	}
+	_fraigSec = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+}
+//SAT and exhaustive simulation calls, pairs decided by any means (cache
+//hits included) and wall-clock time of the last fraig
+void
+CirMgr::printFraigStat() const
+{
+	cout<<"Fraig statistics"<<endl;
+	cout<<"=================="<<endl;
+	cout<<"  Threads"<<setw(11)<<_fraigThreads<<endl;
+	cout<<"  Cex expand"<<setw(8)<<(_cexExpand ? "on" : "off")<<endl;
+	cout<<"  SAT calls"<<setw(9)<<_satCalls<<endl;
+	cout<<"  Sim calls"<<setw(9)<<_simCalls<<endl;
+	cout<<"  Proven"<<setw(12)<<_fraigProven<<endl;
+	cout<<"  Disproven"<<setw(9)<<_fraigDisproven<<endl;
+	cout<<"  Undecided"<<setw(9)<<_fraigUndecided<<endl;
+	cout<<"  Resim"<<setw(13)<<_cexRounds<<endl;
+	cout<<"  CNF vars"<<setw(10)<<_cnfVars<<endl;
+	cout<<"  CNF gates"<<setw(9)<<_cnfGates<<endl;
+	cout<<"  Rebuilds"<<setw(10)<<_satRebuilds<<endl;
+	if(_proofCache.enabled()){
+		cout<<"  Cache hits"<<setw(8)<<_cacheHits<<" / "<<_cacheLookups;
+		if(_cacheLookups>0)
+			cout<<" ("<<fixed<<setprecision(1)<<100.0*_cacheHits/_cacheLookups
+				<<"%)"<<defaultfloat;
+		cout<<endl;
+		cout<<"  Cache size"<<setw(8)<<_proofCache.size()<<endl;
+	}
+	cout<<"  Time"<<setw(14)<<fixed<<setprecision(3)<<_fraigSec<<" s"
+		<<defaultfloat<<endl;
 }
 
 
 /********************************************/
 /*   Private member functions about fraig   */
 /********************************************/
+//counterexample numSig goes to bit 63-numSig%64 of word numSig/64, or,
+//expanded, to bit 63 of word numSig with its distance-1 neighbours
+//below: bit 62-k flips the k-th PI of the pair's support. _sigList holds
+//the words PI by PI, word after word. PIs outside the support (cex<0)
+//keep their old value, or are random when expanded since they can still
+//split other groups.
 void
-CirMgr::genProofModel(SatSolver& s){
-	int id0,id1; bool ph0,ph1;
-	Var v;
-
-	// CONST_GATE
-	v = s.newVar();
-	_gateList[0]->setVar(v);
-	s.addAigCNF(v,v,true,v,false);
-	for(int i=0;i<_piList.size();i++){
-		v = s.newVar();
-		_piList[i]->setVar(v);
-	}
-	for(int i=0;i<_dfsList.size();i++){
-		CirGate *g = _dfsList[i];
-		if(g->getType()==AIG_GATE){
-			v = s.newVar();
-			g->setVar(v);
-		}
-		else if(g->getType()==PO_GATE){
-			id0 = g->getFaninGateID(0);
-			g->setVar(_gateList[id0]->getVar());
-		}
-		
-		if(g->getType()==AIG_GATE){
-			id0 = g->getFaninGateID(0); ph0 = g->getFaninGatePhase(0);
-			id1 = g->getFaninGateID(1); ph1 = g->getFaninGatePhase(1);
-			s.addAigCNF(g->getVar(),_gateList[id0]->getVar(),ph0,
-						_gateList[id1]->getVar(),ph1);
+CirMgr::collectPattern(int numSig, const vector<char> &cex){
+	size_t n = _piList.size();
+	if(_cexExpand){
+		size_t *sig;
+		_sigList.resize((numSig+1)*n);
+		int k=0;
+		for(int i=0;i<_piList.size();i++){
+			sig = &_sigList[numSig*n+i];
+			if(cex[i]<0){
+				*sig = _rng();
+				continue;
+			}
+			*sig = cex[i] ? ~size_t(0) : 0;
+			if(k<63) *sig ^= size_t(1)<<(62-k++);
 		}
+		return;
+	}
+	unsigned w = numSig/64;
+	if(numSig%64==0){
+		_sigList.resize((w+1)*n);
+		for(int i=0;i<_piList.size();i++)
+			_sigList[w*n+i] = _aig.sig(_piList[i]->getID(),w);
+	}
+	size_t mask = size_t(1)<<(63-numSig%64), *sig = &_sigList[w*n];
+	for(int i=0;i<_piList.size();i++){
+		if(cex[i]<0) continue;
+		sig[i] = cex[i] ? (sig[i] | mask) : (sig[i] & ~mask);
 	}
 }
-bool
-CirMgr::ProvePair(SatSolver &solver,int id0,bool ph0,int id1,bool ph1){
-	Var newV = solver.newVar();
-	solver.addXorCNF(newV,_gateList[id0]->getVar(),ph0,
-					_gateList[id1]->getVar(),ph1);
-	
-	//four types of FEC pair
-	//solver.addXorCNF(vf, va, fa, vb, fb)
-	//	 a, b ->  a!= b, (fa=0,fb=0), unsat means  a == b, merge( a, b,0)
-	//	 a,!b ->  a!=!b, (fa=0,fb=1), unsat means  a ==!b, merge( a,!b,1)
-	//	!a, b -> !a!= b, (fa=1,fb=0), unsat means !a == b, merge(!a, b,1)
-	//	!a,!b -> !a!=!b, (fa=1,fb=1), unsat means !a ==!b, merge(!a,!b,0)
-					
-	solver.assumeRelease();
-	solver.assumeProperty(newV,true);
-	bool result = solver.assumpSolve();
-	return result;
-}
+//resimulate the numSig collected counterexamples and refine _fec. One
+//word is resimulated event-driven, more words with full passes of up to
+//words() words each.
 void
-CirMgr::collectPattern(SatSolver &solver, int numSig){
-	for(int i=0;i<_piList.size();i++){
-		size_t a = solver.getValue(_piList[i]->getVar());
-		assert(a==0 || a==1);
-		if(numSig==0) _sigList.push_back(a);
-		else _sigList[i]=(_sigList[i]<<1)+a;
+CirMgr::resimCex(int numSig)
+{
+	_cexRounds++;
+	int nw = _cexExpand ? numSig : (numSig+63)/64;
+	int num = _cexExpand ? 64*numSig : numSig;
+	if(nw==1){
+		resimulate();
+		if(_simLog!=NULL) writeSim(num);
+		return;
+	}
+	size_t n = _piList.size();
+	int W = _aig.words();
+	for(int w0=0;w0<nw;w0+=W){
+		int cw = min(nw-w0,W);
+		for(int w=0;w<cw;w++)
+			for(size_t i=0;i<n;i++)
+				_aig.setSig(_piList[i]->getID(),_sigList[(w0+w)*n+i],w);
+		simulate(cw);
+		for(int w=0;w<cw;w++,num-=64){
+			if(_simLog!=NULL) writeSim(min(num,64),w);
+			IdentifyFEC(w);
+		}
 	}
 }
 
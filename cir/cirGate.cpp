@@ -22,6 +22,8 @@ extern CirMgr *cirMgr;
 /*   Static varaibles and functions   */
 /**************************************/
 size_t CirGate::_globalRef=0;
+CirArena *CirGate::_arena=NULL;
+CirFanout *CirGate::_fanout=NULL;
 
 /**************************************/
 /*   class CirGate member functions   */
@@ -102,16 +104,17 @@ CirGate::reportFanout(int level) const
 }
 void
 CirGate::recurFanout(int level,int space)const{
-   if(level==0||_fanoutList==NULL) return;
+   if(level==0||_fanout->size(_gateID)==0) return;
 
-   for(int i=0;i<_fanoutList ->size();i++){
+   for(unsigned k=_fanout->begin(_gateID);k<_fanout->end(_gateID);k++){
+	   if(_fanout->dead(k)) continue;
 	   cout<<string(space,' ');
 	   cout<<"  ";
-	   if(_fanoutList->at(i)->isInv())
+	   if(_fanout->isInv(k))
 		   cout<<"!";
 	   
-	   CirGate *g = _fanoutList -> at(i)->gate();
-	   if(g->_ref == _globalRef && level>1 && g ->_fanoutList!=NULL)
+	   CirGate *g = cirMgr->getGate(_fanout->gate(k));
+	   if(g->_ref == _globalRef && level>1 && _fanout->size(g->_gateID))
 		   cout<<g->getTypeStr()<<" "<<g->getID()<<" (*)"<<endl;
 	   else{
 		   if(level>1) g->_ref = _globalRef;
@@ -124,30 +127,28 @@ CirGate::recurFanout(int level,int space)const{
 // Fanin related
 void
 CirGate::setFanin(size_t var){
-	CirGateV *g = new CirGateV;
-	size_t *tmp = (size_t*)((void*)g);
-	*tmp = var;
+	CirGateV *g = new(*_arena) CirGateV;
+	g->_gateV = var;
 
-	if(_faninList == NULL)
+	if(_faninList == NULL){
 		_faninList = new vector<CirGateV*>;
+		_faninList->reserve(_type==AIG_GATE ? 2 : 1);
+	}
 	_faninList-> push_back(g);
 }
+//the edge holding the raw literal is reused
 void
 CirGate::setFanin(CirGate* g,size_t phase,int i){
 	assert(_faninList!= NULL && i< _faninList -> size());
-	CirGateV *gv = new CirGateV(g,phase);
-	_faninList -> at(i) = gv;
+	_faninList -> at(i) -> _gateV = size_t(g) + phase;
 }
 //replace one of the fanin whose id=orgin to (g,phase)
 //return number of replacement
 void
 CirGate::replaceFanin(size_t orgin, CirGate* g,size_t phase){
 	for(int i=0;i<FaninSize();i++){
-		if(getFaninGateID(i)==orgin){
-			CirGateV *gv = new CirGateV(g,phase);
-			delete _faninList->at(i);
-			_faninList->at(i)=gv;
-		}
+		if(getFaninGateID(i)==orgin)
+			_faninList->at(i)->_gateV = size_t(g) + phase;
 	}
 }
 size_t
@@ -156,43 +157,3 @@ CirGate::getFanin(int i){
 	size_t *tmp = (size_t*)((void*)g);
 	return *tmp;
 }
-//Fanout related
-void
-CirGate::setFanout(CirGate* g, size_t phase){
-	if(_fanoutList == NULL)
-		_fanoutList = new vector<CirGateV*>;
-	CirGateV *gv = new CirGateV(g,phase);
-	_fanoutList -> push_back(gv);
-}
-//remove all of the fanout=id
-void 
-CirGate::removeFanout(size_t id){
-	for(int i=0;i<FanoutSize();++i){
-		if(getFanoutGateID(i)==id){
-			_fanoutList->erase(_fanoutList->begin()+i);
-			i--; //restart from i
-		}
-	}
-}
-
-//dfs related
-void 
-CirGate::dfs(vector<CirGate*> &_dfsList){
-	if(_faninList == NULL) { 
-		_dfsList.push_back(this);
-		return;
-	}
-	for(int i=0;i<_faninList->size();i++){
-		CirGate *g = _faninList->at(i)->gate();
-		if(g->getType()==UNDEF_GATE){ g->setReach(true); continue;}
-		if(g->_ref != _globalRef){
-			g->_ref = _globalRef;
-			g->dfs(_dfsList);
-		}
-	}
-	this->setReach(true);
-	_dfsList.push_back(this);
-}
-
-
-
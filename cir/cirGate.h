@@ -13,6 +13,8 @@
 #include <vector>
 #include <iostream>
 #include "cirDef.h"
+#include "cirArena.h"
+#include "cirFanout.h"
 #include "sat.h"
 
 using namespace std;
@@ -25,7 +27,6 @@ class CirAigGate;
 class CirConstGate;
 class CirUndefGate;
 class HashKey;
-typedef vector<int> FECgroup;
 //------------------------------------------------------------------------
 //   Define classes
 //------------------------------------------------------------------------
@@ -49,8 +50,8 @@ class CirGate
 public:
    CirGate(){}
    CirGate(size_t gateID, size_t lineNo, GateType type):
-	   _gateID(gateID),_lineNo(lineNo),_type(type),_reachFromPo(false),_signal(0), 
-	   _fgp(NULL), _dfsNum(-1),_faninList(NULL), _fanoutList(NULL),_sym(NULL),_ref(0){}
+	   _gateID(gateID),_lineNo(lineNo),_type(type),_reachFromPo(false),
+	   _dfsNum(-1),_faninList(NULL),_sym(NULL),_ref(0){}
    virtual ~CirGate() {}
 
    // Basic access methods
@@ -88,47 +89,24 @@ public:
    bool getFaninGatePhase(int i) { return _faninList -> at(i) -> isInv();}
    CirGateV* getFaninCirGateV(int i){ return _faninList -> at(i);}
 
-   //Fanout related
-   void setFanout(CirGate *g,size_t phase);
-   void clearFanout(){ 
-	   if(_fanoutList==NULL) return;
-	   else _fanoutList->clear();
-   }
-   void removeFanout(size_t id); //remove all of the fanout=id 
-   size_t FanoutSize(){
-	   if(_fanoutList==NULL) return 0;
-	   else return _fanoutList -> size();
-   }
-   size_t getFanoutGateID(const int &i){ return _fanoutList->at(i)->gate()->getID();}
-   bool getFanoutGatePhase(const int &i){ return _fanoutList->at(i)->isInv();}
+   //Fanout related, fanouts are kept in the circuit's CSR index
+   size_t FanoutSize() const { return _fanout->size(_gateID); }
 
 
    //sym related
    void setSym(string &name) { _sym = new string(name);}
    string * getSym() {return _sym;}
 
-   //dfs  related
-   static void setglobalRef(){ _globalRef++; }
-   void dfs(vector<CirGate*> &_dfsList);
+   //edges are allocated from the circuit's arena
+   static void setArena(CirArena *a){ _arena = a; }
+   static CirArena* getArena(){ return _arena; }
+   static void setFanoutIndex(CirFanout *f){ _fanout = f; }
+   static CirFanout* getFanoutIndex(){ return _fanout; }
 
    //Reachable from Po
    void setReach(bool reach){ _reachFromPo = reach;}
    bool getReach() const { return _reachFromPo;}
 
-   //Signal
-   void setSignal(const size_t &sig){ _signal = sig; }
-   size_t getSignal(const bool &phase) const { 
-	   if(phase) return ~_signal; 
-	   else return _signal;
-   }
-   //FECgroup related
-   void setFgp(FECgroup *fgp){ _fgp = fgp; }
-   FECgroup* getFgp() const { return _fgp; }
-
-   //Var related
-   void setVar(const Var &v){ _var = v; }
-   Var getVar() const { return _var; }
-
    //_dfsNum related
    void setDfsNum(const int& n) { _dfsNum=n; }
    int getDfsNum() const { return _dfsNum; }
@@ -139,19 +117,17 @@ private:
    size_t _lineNo;
    GateType _type;
    bool _reachFromPo;
-   size_t _signal;
-   FECgroup *_fgp;
-   Var _var; //sat var
    int _dfsNum;
 
-   //Gate dfs information
+   //Gate report information
    size_t _ref;
    static size_t _globalRef;
+   static CirArena *_arena;
+   static CirFanout *_fanout;
 
 protected:
    string  *_sym;
    vector<CirGateV*> *_faninList;
-   vector<CirGateV*> *_fanoutList;
 };
 
 class CirPiGate: public CirGate
@@ -161,7 +137,6 @@ public:
 	CirPiGate(size_t gateID,size_t lineNo):CirGate(gateID,lineNo,PI_GATE) {}
 	~CirPiGate() {
 		assert(_faninList == NULL);
-		if(_fanoutList!=NULL) delete _fanoutList;
 		if(_sym!=NULL) delete _sym;
 	}
 
@@ -178,7 +153,6 @@ public:
 	CirPoGate(){}
 	CirPoGate(size_t gateID,size_t lineNo):CirGate(gateID,lineNo,PO_GATE) {}
 	~CirPoGate() {
-		assert(_fanoutList == NULL);
 		if(_faninList!=NULL) delete _faninList;
 		if(_sym!=NULL) delete _sym;
 	}
@@ -203,7 +177,6 @@ public:
 	~CirAigGate() {
 		assert(_sym==NULL);
 		if(_faninList!=NULL) delete _faninList;
-		if(_fanoutList!=NULL) delete _fanoutList;
 	}
 
 	void printGate()const{
@@ -227,7 +200,6 @@ public:
 
 	~CirConstGate(){
 		assert(_faninList == NULL);
-		if(_fanoutList!=NULL) delete _fanoutList;
 		if(_sym!=NULL) delete _sym;
 	}
 	void printGate() const{ cout<<" CONST0"<<endl;}
@@ -240,7 +212,6 @@ public:
 
 	~CirUndefGate(){
 		assert(_faninList==NULL);
-		if(_fanoutList!=NULL) delete _fanoutList;
 		assert(_sym ==NULL);
 	}
 	void printGate() const{}
@@ -13,6 +13,10 @@
 #include <ctype.h>
 #include <cassert>
 #include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
@@ -30,6 +34,73 @@ CirMgr* cirMgr = 0;
 //constant zero gate
 CirGate *CirMgr::_const0 = new CirConstGate(0,0);
 
+/**************************************************************/
+/*   class CirMgr constructor & destructor                    */
+/**************************************************************/
+CirMgr::CirMgr(): _simLog(NULL), _numThreads(1),
+	_dfsDirty(false), _dfsSpliced(false), _coneSim(false), _coneLits(0),
+	_cexExpand(false), _fraigThreads(1), _pairBudget(0), _timeBudget(0),
+	_satCalls(0), _satCex(0), _cexRounds(0), _fraigSec(0),
+	_cnfVars(0), _cnfGates(0), _satRebuilds(0), _simCalls(0), _simCex(0),
+	_cacheLookups(0), _cacheHits(0), _fraigProven(0), _fraigDisproven(0),
+	_fraigUndecided(0)
+{
+	CirGate::setArena(&_arena);
+	CirGate::setFanoutIndex(&_fanout);
+}
+//gates & edges live in _arena: only the per-gate vectors and symbols
+//are released one by one, the rest is freed at once with the arena
+CirMgr::~CirMgr()
+{
+	for(int i=0;i<_gateList.size();i++){
+		if(_gateList[i]!=NULL && _gateList[i]!=_const0)
+			_gateList[i]->~CirGate();
+	}
+	if(CirGate::getArena()==&_arena) CirGate::setArena(NULL);
+	if(CirGate::getFanoutIndex()==&_fanout) CirGate::setFanoutIndex(NULL);
+}
+
+//Binary AIGER helpers, cur is advanced past the parsed token
+static bool
+parseUnsigned(const char *&cur, const char *end, size_t &n){
+	while(cur<end && (*cur==' ' || *cur=='\n' || *cur=='\r')) ++cur;
+	if(cur==end || !isdigit(*cur)) return false;
+	n=0;
+	while(cur<end && isdigit(*cur)) n = n*10 + (*cur++ - '0');
+	return true;
+}
+//mmap whole file read-only, NULL if it can't be opened or is empty
+const char*
+CirMgr::mapFile(const string &fileName, size_t &len){
+	int fd = open(fileName.c_str(),O_RDONLY);
+	if(fd<0) return NULL;
+	struct stat st;
+	if(fstat(fd,&st)<0 || st.st_size==0){ close(fd); return NULL; }
+	len = st.st_size;
+	void *buf = mmap(NULL,len,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(buf==MAP_FAILED) return NULL;
+	madvise(buf,len,MADV_SEQUENTIAL);
+	return (const char*)buf;
+}
+//bytes glibc malloc takes for a request of n: 8 of header, 16-aligned,
+//32 at least
+static size_t
+mallocChunk(size_t n){
+	return max(size_t(32),(n+8+15) & ~size_t(15));
+}
+//delta of binary AND section: 7 bits per byte, msb set if more bytes follow
+static bool
+decodeDelta(const char *&cur, const char *end, size_t &d){
+	d=0;
+	for(int shift=0;cur<end;shift+=7){
+		unsigned char ch = *cur++;
+		d |= size_t(ch & 0x7f)<<shift;
+		if(!(ch & 0x80)) return true;
+	}
+	return false;
+}
+
 /**************************************************************/
 /*   class CirMgr member functions for Access        		  */
 /**************************************************************/
@@ -47,6 +118,18 @@ bool
 CirMgr::readCircuit(const string& fileName)
 {
 	ifstream fin(fileName);
+	//pick format from the header: "aag" is ASCII, "aig" is binary
+	char fmt[3]={0};
+	fin.read(fmt,3);
+	if(fin && strncmp(fmt,"aig",3)==0){
+		fin.close();
+		return readBinary(fileName);
+	}
+	fin.clear(); fin.seekg(0);
+	if(_numThreads>1){
+		fin.close();
+		return readParallel(fileName);
+	}
 	if(readHeader(fin) && readInput(fin) && readOutput(fin)  
 		&& readAIG(fin) && readSym(fin) && readComment(fin)){
 		connect();
@@ -67,7 +150,7 @@ CirMgr::readInput(ifstream &fin){
 	for(int i=0;i<I;i++){
 		fin>>gateID; gateID = gateID>>1; //gateID = gateID/2
 		lineNo = i+2; //when i=0,lineNo=2
-		CirPiGate  *pi =  new CirPiGate(gateID,lineNo);
+		CirPiGate  *pi =  new(_arena) CirPiGate(gateID,lineNo);
 		_piList.push_back(pi);
 		if(_gateList.size()<gateID+1) _gateList.resize(gateID+1,NULL);
 		_gateList[gateID] = pi;
@@ -81,7 +164,7 @@ CirMgr::readOutput(ifstream &fin){
 	for(int i=0;i<O;i++){
 		gateID = M+1+i;
 		lineNo = i+I+2; //when I=1,i=0,lineNo = 3
-		CirPoGate *po = new CirPoGate(gateID,lineNo);
+		CirPoGate *po = new(_arena) CirPoGate(gateID,lineNo);
 		fin>>var; po -> setFanin(var);
 		_poList.push_back(po);
 		if(_gateList.size()<gateID+1) _gateList.resize(gateID+1,NULL);
@@ -97,7 +180,7 @@ CirMgr::readAIG(ifstream &fin){
 		fin>>gateID>>var1>>var2;
 		gateID=gateID>>1;
 		lineNo = i+I+O+2;
-		CirGate *a = new CirAigGate(gateID,lineNo);
+		CirGate *a = new(_arena) CirAigGate(gateID,lineNo);
 		a -> setFanin(var1); a -> setFanin(var2);
 		if(_gateList.size()<gateID+1) _gateList.resize(gateID+1,NULL);
 		_gateList[gateID] = a;
@@ -130,6 +213,197 @@ CirMgr::readComment(ifstream &fin){
 	 while(fin>>comment){}
 	 return true;
 }
+//map the whole file and decode it in place, no intermediate copy
+bool
+CirMgr::readBinary(const string& fileName){
+	size_t len;
+	const char *buf = mapFile(fileName,len);
+	if(buf==NULL) return false;
+
+	const char *cur = buf, *end = buf+len;
+	bool ok = readHeader(cur,end) && readBinaryIO(cur,end)
+		&& readBinaryAIG(cur,end) && readSym(cur,end);
+	munmap((void*)buf,len);
+	if(!ok) return false;
+	connect();
+	dfs();
+	return true;
+}
+//ASCII file split into _numThreads chunks, parsed and connected concurrently
+bool
+CirMgr::readParallel(const string& fileName){
+	size_t len;
+	const char *buf = mapFile(fileName,len);
+	if(buf==NULL) return false;
+
+	const char *cur = buf, *end = buf+len;
+	bool ok = readHeader(cur,end) && readInput(cur,end) 
+		&& readOutput(cur,end) && readAIGParallel(cur,end) 
+		&& readSym(cur,end);
+	munmap((void*)buf,len);
+	if(!ok) return false;
+	connectParallel();
+	dfs();
+	return true;
+}
+bool
+CirMgr::readHeader(const char *&cur, const char *end){
+	size_t m,i,l,o,a;
+	cur+=3; //"aag" or "aig"
+	if(!parseUnsigned(cur,end,m) || !parseUnsigned(cur,end,i) 
+		|| !parseUnsigned(cur,end,l) || !parseUnsigned(cur,end,o)
+		|| !parseUnsigned(cur,end,a)) return false;
+	if(l!=0){
+		cerr<<"Error: latches are not supported!!"<<endl;
+		return false;
+	}
+	M=m; I=i; L=l; O=o; A=a;
+	//every ID is known from the header, so the table is allocated once
+	_gateList.resize(M+O+1,NULL);
+	_piList.reserve(I); _poList.reserve(O);
+	return true;
+}
+bool
+CirMgr::readInput(const char *&cur, const char *end){
+	size_t var;
+	for(int i=0;i<I;i++){
+		if(!parseUnsigned(cur,end,var) || (var>>1)>M) return false;
+		CirPiGate *pi = new(_arena) CirPiGate(var>>1,i+2);
+		_piList.push_back(pi);
+		_gateList[var>>1] = pi;
+	}
+	return true;
+}
+bool
+CirMgr::readOutput(const char *&cur, const char *end){
+	size_t var;
+	for(int i=0;i<O;i++){
+		if(!parseUnsigned(cur,end,var)) return false;
+		if((var>>1)>M){
+			cerr<<"Error: PO "<<i<<" literal "<<var<<" exceeds M!!"<<endl;
+			return false;
+		}
+		CirPoGate *po = new(_arena) CirPoGate(M+1+i,i+I+2);
+		po -> setFanin(var);
+		_poList.push_back(po);
+		_gateList[M+1+i] = po;
+	}
+	//skip to the first byte of the AND section
+	while(cur<end && *cur!='\n') ++cur;
+	if(cur<end) ++cur;
+	return true;
+}
+bool
+CirMgr::readBinaryIO(const char *&cur, const char *end){
+	//IDs are implicit, so the header has to count them exactly
+	if(M!=I+L+A){
+		cerr<<"Error: M != I+L+A in binary AIG header!!"<<endl;
+		return false;
+	}
+	//inputs are implicit: literal 2,4,...,2I
+	for(int i=0;i<I;i++){
+		CirPiGate *pi = new(_arena) CirPiGate(i+1,i+2);
+		_piList.push_back(pi);
+		_gateList[i+1] = pi;
+	}
+	return readOutput(cur,end);
+}
+bool
+CirMgr::readBinaryAIG(const char *&cur, const char *end){
+	size_t lhs,d0,d1,var1,var2;
+	for(int i=0;i<A;i++){
+		lhs = 2*(I+L+i+1);
+		if(!decodeDelta(cur,end,d0) || !decodeDelta(cur,end,d1)){
+			cerr<<"Error: AND gate "<<(lhs>>1)<<" is truncated!!"<<endl;
+			return false;
+		}
+		//lhs > rhs0 >= rhs1, a zero d0 makes the gate its own fanin and
+		//deltas past 0 would wrap around
+		if(d0==0 || d0>lhs || d1>lhs-d0 || (lhs>>1)>M){
+			cerr<<"Error: AND gate "<<(lhs>>1)<<" has illegal deltas!!"<<endl;
+			return false;
+		}
+		var1 = lhs-d0; var2 = var1-d1;
+		CirGate *a = new(_arena) CirAigGate(lhs>>1,i+I+O+2);
+		a -> setFanin(var1); a -> setFanin(var2);
+		_gateList[lhs>>1] = a;
+	}
+	return true;
+}
+//1. count lines of each chunk, 2. prefix sum gives the first AND index
+//of each chunk, 3. parse chunks into the preallocated _gateList
+bool
+CirMgr::readAIGParallel(const char *&cur, const char *end){
+	int T = _numThreads;
+	size_t len = end-cur;
+	if(T<1 || len < size_t(T)*4096) T = 1;
+	vector<const char*> bgn(T+1);
+	bgn[0] = cur; bgn[T] = end;
+	for(int t=1;t<T;t++){
+		//align chunk boundaries to line starts
+		const char *p = cur + len*t/T;
+		while(p<end && p[-1]!='\n') ++p;
+		bgn[t] = max(p,bgn[t-1]);
+	}
+	vector<size_t> lines(T+1,0);
+	parallelRun(T,[&](int t){
+		for(const char *p=bgn[t];p<bgn[t+1];++p)
+			if(*p=='\n') lines[t+1]++;
+	});
+	for(int t=0;t<T;t++) lines[t+1]+=lines[t];
+
+	vector<char> ok(T,1);
+	vector<size_t> parsed(T,0);
+	vector<const char*> stop(T,(const char*)NULL);
+	parallelRun(T,[&](int t){
+		const char *p = bgn[t];
+		size_t gateID,var1,var2;
+		for(size_t i=lines[t];i<A && p<bgn[t+1];i++){
+			if(!parseUnsigned(p,end,gateID) || !parseUnsigned(p,end,var1)
+				|| !parseUnsigned(p,end,var2) || (gateID>>1)>M){
+				ok[t]=0; return;
+			}
+			CirGate *a = new(_arena) CirAigGate(gateID>>1,i+I+O+2);
+			a -> setFanin(var1); a -> setFanin(var2);
+			_gateList[gateID>>1] = a;
+			while(p<end && *p!='\n') ++p;
+			if(p<end) ++p;
+			parsed[t]++;
+			if(i+1==A) stop[t] = p;
+		}
+	});
+	size_t total=0;
+	for(int t=0;t<T;t++){
+		if(!ok[t]) return false;
+		if(stop[t]!=NULL) cur = stop[t];
+		total+=parsed[t];
+	}
+	return total==A;
+}
+bool
+CirMgr::readSym(const char *&cur, const char *end){
+	while(cur<end && (*cur=='i' || *cur=='o')){
+		const char *eol = (const char*)memchr(cur,'\n',end-cur);
+		if(eol==NULL) eol = end;
+		const char *sp = (const char*)memchr(cur,' ',eol-cur);
+		if(sp==NULL) return false;
+		size_t id=0;
+		for(const char *p=cur+1;p<sp;p++){
+			if(!isdigit(*p)) return false;
+			id = id*10 + (*p-'0');
+		}
+		string name(sp+1,eol);
+		if(id>=(*cur=='i' ? _piList.size() : _poList.size())){
+			cerr<<"Error: symbol "<<*cur<<id<<" is out of range!!"<<endl;
+			return false;
+		}
+		if(*cur=='i') _piList[id] -> setSym(name);
+		else _poList[id] -> setSym(name);
+		cur = (eol<end ? eol+1 : end);
+	}
+	//the rest is comment
+	return true;
+}
 void
 CirMgr::connect(){
 	//set const zero
@@ -150,14 +424,14 @@ CirMgr::connect(){
 					if(_floatList.empty()||_floatList.back()!=g)
 						_floatList.push_back(g);//prevent repeat
 					if(_gateList[id]== NULL) 
-						_gateList[id] = new CirUndefGate(id,0);
+						_gateList[id] = new(_arena) CirUndefGate(id,0);
 				}
-				//even undefined gate has to set fanout & fanin
-				_gateList[id] -> setFanout(g,phase);		
 				g -> setFanin(_gateList[id],phase,j);
 			}
 		}
 	}
+	//even undefined gate has fanouts
+	_fanout.build(_gateList);
 	//check undefined: case a,c
 	for(int i=0;i<_gateList.size();i++){
 		CirGate *g = _gateList[i];
@@ -169,17 +443,128 @@ CirMgr::connect(){
 		}
 	}
 }
+//same result as connect(), the fanout index is built with all threads
+void
+CirMgr::connectParallel(){
+	_gateList[0] = _const0;
+	int T = max(_numThreads,1);
+	size_t n = _gateList.size();
+	#define CHUNK_BGN(t,n) ((n)*(t)/T)
+
+	//1. undefined IDs, created serially since there are usually few
+	vector<IdList> undef(T);
+	parallelRun(T,[&](int t){
+		for(size_t i=CHUNK_BGN(t,n);i<CHUNK_BGN(t+1,n);i++){
+			CirGate *g = _gateList[i];
+			if(g==NULL || (g->getType()!=PO_GATE && g->getType()!=AIG_GATE)) 
+				continue;
+			for(int j=0;j<g->FaninSize();j++){
+				size_t id = g->getFanin(j)/2;
+				if(id>=n || _gateList[id]==NULL) undef[t].push_back(id);
+			}
+		}
+	});
+	for(int t=0;t<T;t++){
+		for(int k=0;k<undef[t].size();k++){
+			size_t id = undef[t][k];
+			if(id>=_gateList.size()) _gateList.resize(id+1,NULL);
+			if(_gateList[id]==NULL) _gateList[id] = new(_arena) CirUndefGate(id,0);
+		}
+	}
+	size_t m = _gateList.size();
+
+	//2. fanin pointers and floating gates
+	vector<GateList> floating(T);
+	parallelRun(T,[&](int t){
+		for(size_t i=CHUNK_BGN(t,n);i<CHUNK_BGN(t+1,n);i++){
+			CirGate *g = _gateList[i];
+			if(g==NULL || (g->getType()!=PO_GATE && g->getType()!=AIG_GATE)) 
+				continue;
+			for(int j=0;j<g->FaninSize();j++){
+				size_t lit = g->getFanin(j);
+				size_t id = lit/2; size_t phase = lit%2;
+				if(_gateList[id]->getType()==UNDEF_GATE){
+					if(floating[t].empty()||floating[t].back()!=g)
+						floating[t].push_back(g);
+				}
+				g -> setFanin(_gateList[id],phase,j);
+			}
+		}
+	});
+	for(int t=0;t<T;t++)
+		_floatList.insert(_floatList.end(),floating[t].begin(),floating[t].end());
+
+	//3. fanouts
+	_fanout.build(_gateList,T);
+
+	//4. unused gates
+	vector<GateList> unuse(T);
+	parallelRun(T,[&](int t){
+		for(size_t i=CHUNK_BGN(t,m);i<CHUNK_BGN(t+1,m);i++){
+			CirGate *g = _gateList[i];
+			if(g == NULL) continue;
+			else if(g -> getType() == PI_GATE 
+					|| g-> getType()== AIG_GATE){
+				if(g -> FanoutSize() == 0)
+					unuse[t].push_back(g);
+			}
+		}
+	});
+	for(int t=0;t<T;t++)
+		_unuseList.insert(_unuseList.end(),unuse[t].begin(),unuse[t].end());
+	#undef CHUNK_BGN
+}
 void
 CirMgr::dfs(){
-	CirGate::setglobalRef();
-	for(int i=0;i<_poList.size();i++)
-		_poList[i] -> dfs(_dfsList);
+	vector<unsigned> level(_gateList.size(),0);
+	GateList roots(_poList.begin(),_poList.end());
+	dfsOrder(roots,_dfsList,&level);
+	_dfsSpliced = false;
 	Aw=0;
 	for(int i=0;i<_dfsList.size();i++){
 		_dfsList[i]->setDfsNum(i);
 		if(_dfsList[i]->getType()==AIG_GATE)
 			Aw++;
 	}
+	_aig.build(_gateList,_dfsList,level);
+}
+//Post-order from roots with an explicit stack, one frame (gate, next
+//fanin) per gate on the current path, so depth is not limited by the
+//call stack. UNDEF fanins are marked reachable but not listed.
+//level, if given, gets 0 for PI/CONST/UNDEF and the number of AIG
+//gates on the longest path otherwise.
+void
+CirMgr::dfsOrder(const GateList &roots, GateList &order, 
+	vector<unsigned> *level) const
+{
+	vector<char> mark(_gateList.size(),0);
+	vector< pair<CirGate*,int> > stack;
+	for(int r=0;r<roots.size();r++){
+		stack.push_back(make_pair(roots[r],0));
+		while(!stack.empty()){
+			CirGate *g = stack.back().first;
+			int i = stack.back().second;
+			if(i<g->FaninSize()){
+				stack.back().second++;
+				CirGate *f = _gateList[g->getFaninGateID(i)];
+				if(f->getType()==UNDEF_GATE){ f->setReach(true); continue; }
+				if(!mark[f->getID()]){
+					mark[f->getID()]=1;
+					stack.push_back(make_pair(f,0));
+				}
+				continue;
+			}
+			stack.pop_back();
+			if(g->FaninSize()) g->setReach(true);
+			if(level!=NULL){
+				unsigned lv=0;
+				for(int j=0;j<g->FaninSize();j++)
+					lv = max(lv,(*level)[g->getFaninGateID(j)]);
+				(*level)[g->getID()] = lv + (g->getType()==AIG_GATE);
+			}
+			order.push_back(g);
+		}
+	}
 }
 
 /**********************************************************/
@@ -208,9 +593,10 @@ CirMgr::printSummary() const
 }
 
 void
-CirMgr::printNetlist() const
+CirMgr::printNetlist()
 {
 
+   canonDfs();
    cout << endl;
    for (unsigned i = 0, n = _dfsList.size(); i < n; ++i) {
       cout << "[" << i << "]";
@@ -253,32 +639,68 @@ CirMgr::printFloatGates() const
 	}
 }
 
+//groups in the order of their first gate ID
 void
 CirMgr::printFECPairs() const
 {
-	setFirstFgp();
+	vector<pair<unsigned,unsigned> > first;
+	for(size_t g=0;g<_fec.size();g++)
+		first.push_back(make_pair(_fec.lit(g,0)/2,g));
+	sort(first.begin(),first.end());
 	//Print
-	int n=0;
+	for(int n=0;n<first.size();n++){
+		unsigned g = first[n].second;
+		cout<<"["<<n<<"]";
+		bool fstPhase = _fec.lit(g,0)%2;
+		for(unsigned j=0;j<_fec.grpSize(g);j++){
+			int id = _fec.lit(g,j)/2; bool phase = _fec.lit(g,j)%2;
+			if(phase!=fstPhase) cout<<" !"<<id; //no ! before first id
+			else cout<<" "<<id;
+		}
+		cout<<endl;
+	}
+}
+
+//footprint of the circuit: the CirGate graph, plus the flat CirAig copy
+//and the FEC groups kept next to it
+void
+CirMgr::printMemUsage() const
+{
+	//gates and their CirGateV edges are in the arena blocks; the fanin
+	//vectors and symbols are malloc'ed one by one
+	size_t heapBytes=0, nGate=0;
 	for(int i=0;i<_gateList.size();i++){
 		CirGate *g = _gateList[i];
-		if(g!=NULL && g->getFgp()!=NULL){
-			FECgroup *grp = g->getFgp();
-			cout<<"["<<n<<"]";
-			bool fstPhase = grp->at(0)%2;
-			for(int j=0;j<grp->size();j++){
-				int id = grp->at(j)/2; bool phase = grp->at(j)%2;
-				if(phase!=fstPhase) cout<<" !"<<id; //no ! before first id
-				else cout<<" "<<id;
-			}
-			cout<<endl;
-			n++;
-		}
+		if(g==NULL) continue;
+		nGate++;
+		if(g->FaninSize())
+			heapBytes += mallocChunk(sizeof(vector<CirGateV*>))
+				+ mallocChunk(g->FaninSize()*sizeof(CirGateV*));
+		if(g->getSym()!=NULL)
+			heapBytes += mallocChunk(sizeof(string))
+				+ mallocChunk(g->getSym()->capacity()+1);
 	}
+	size_t gateBytes = _arena.numBytes() + heapBytes + _fanout.memUsage()
+		+ (_gateList.capacity()+_dfsList.capacity())*sizeof(CirGate*);
+	size_t aigBytes = _aig.memUsage(), fecBytes = _fec.memUsage();
+	size_t total = gateBytes+aigBytes+fecBytes;
+	if(nGate==0) nGate=1;
+	cout<<"Memory usage"<<endl;
+	cout<<"=================="<<endl;
+	cout<<"  Gates"<<setw(11)<<nGate<<endl;
+	cout<<"  CirGate"<<setw(9)<<gateBytes/nGate<<" B/gate"<<endl;
+	cout<<"  + CirAig"<<setw(8)<<aigBytes/nGate<<" B/gate"<<endl;
+	cout<<"  + FEC"<<setw(11)<<fecBytes/nGate<<" B/gate"<<endl;
+	cout<<"  Total"<<setw(11)<<total/nGate<<" B/gate, "
+		<<total/1024<<" KB"<<endl;
+	cout<<"  Arena"<<setw(11)<<_arena.numBytes()/1024<<" KB in "
+		<<_arena.numBlocks()<<" blocks"<<endl;
 }
 
 void
-CirMgr::writeAag(ostream& outfile) const
+CirMgr::writeAag(ostream& outfile)
 {
+	canonDfs();
 	outfile<<"aag "<<M<<" "<<I<<" "<<L<<" "<<O<<" "<<Aw<<endl;
 	//PI
 	for(int i=0;i<I;i++)
@@ -313,13 +735,70 @@ CirMgr::writeAag(ostream& outfile) const
 	}
 }
 
+//Binary AIGER: gates are renumbered in _dfsList order so that every
+//AND has larger literal than its fanins, whatever holes _gateList has
+void
+CirMgr::writeAig(ostream& outfile)
+{
+	canonDfs();
+	//old gate ID -> new literal, UNDEF & CONST map to 0
+	vector<unsigned> newLit(_gateList.size(),0);
+	unsigned n=0;
+	for(int i=0;i<I;i++)
+		newLit[_piList[i]->getID()] = 2*(++n);
+	for(int i=0;i<_dfsList.size();i++){
+		if(_dfsList[i]->getType()==AIG_GATE)
+			newLit[_dfsList[i]->getID()] = 2*(++n);
+	}
+
+	string buf;
+	buf.reserve(32+12*(I+O)+4*Aw);
+	buf += "aig "+to_string(n)+" "+to_string(I)+" "+to_string(L)+" "
+		+to_string(O)+" "+to_string(Aw)+"\n";
+	//PO
+	for(int i=0;i<O;i++){
+		unsigned lit = newLit[_poList[i]->getFaninGateID(0)]
+			+ _poList[i]->getFaninGatePhase(0);
+		buf += to_string(lit)+"\n";
+	}
+	//AIG, delta encoded 7 bits per byte
+	for(int i=0;i<_dfsList.size();i++){
+		CirGate *g = _dfsList[i];
+		if(g->getType()!=AIG_GATE) continue;
+		unsigned lhs = newLit[g->getID()];
+		unsigned f0 = newLit[g->getFaninGateID(0)] + g->getFaninGatePhase(0);
+		unsigned f1 = newLit[g->getFaninGateID(1)] + g->getFaninGatePhase(1);
+		if(f0<f1) swap(f0,f1);
+		assert(lhs>f0);
+		unsigned delta[2] = { lhs-f0, f0-f1 };
+		for(int j=0;j<2;j++){
+			unsigned d = delta[j];
+			while(d & ~0x7fU){
+				buf += char((d & 0x7f) | 0x80);
+				d >>= 7;
+			}
+			buf += char(d);
+		}
+	}
+	//symbol
+	for(int i=0;i<I;i++){
+		if(_piList[i]->getSym()!=NULL )
+			buf += "i"+to_string(i)+" "+*(_piList[i]->getSym())+"\n";
+	}
+	for(int i=0;i<O;i++){
+		if(_poList[i]->getSym()!=NULL)
+			buf += "o"+to_string(i)+" "+*(_poList[i]->getSym())+"\n";
+	}
+	outfile.write(buf.data(),buf.size());
+	outfile.flush();
+}
+
 void
 CirMgr::writeGate(ostream& outfile, CirGate *g) const
 {
 	vector<int> piCone;
 	vector<CirGate*> dfsCone;
-	CirGate::setglobalRef();
-	g->dfs(dfsCone);
+	dfsOrder(GateList(1,g),dfsCone);
 	int Mc=0,Ic=0,Lc=0,Oc=1,Ac=0;
 	for(int i=0;i<dfsCone.size();i++){
 		if(dfsCone[i]->getType()==PI_GATE){
@@ -14,6 +14,13 @@
 #include <fstream>
 #include <iostream>
 #include "cirGate.h"
+#include "cirAig.h"
+#include "cirArena.h"
+#include "cirFanout.h"
+#include "cirSimLog.h"
+#include "cirFec.h"
+#include "cirProver.h"
+#include "cirProofCache.h"
 #include "sat.h"
 #include "cirDef.h"
 
@@ -21,16 +28,14 @@ using namespace std;
 
 
 extern CirMgr *cirMgr;
-
-typedef vector<int> FECgroup;
+class PatternSource;
 
 class CirMgr
 {
 public:
-   friend class FecListSort;
    friend class FecGrpSort;
-   CirMgr() {}
-   ~CirMgr() {} 
+   CirMgr();
+   ~CirMgr();
 
    // Access functions
    // return '0' if "gid" corresponds to an undefined gate.
@@ -38,6 +43,7 @@ public:
 
    // Member functions about circuit construction
    bool readCircuit(const string&);
+   void setThreadNum(int n) { _numThreads = (n<1 ? 1 : n); }
 
    // Member functions about circuit optimization
    void sweep();
@@ -46,21 +52,37 @@ public:
    // Member functions about simulation
    void randomSim();
    void fileSim(ifstream&);
-   void setSimLog(ofstream *logFile) { _simLog = logFile; }
+   bool fileSim(const string &fileName);
+   void setSimLog(ofstream *logFile);
+   void setSimWords(unsigned nw);
+   void setConeSim(bool on) { _coneSim = on; }
+   void printSimSpeed(unsigned rounds=100);
 
    // Member functions about fraig
    void strash();
    void printFEC() const;
    void fraig();
+   void setCexExpand(bool on) { _cexExpand = on; }
+   void setFraigThreads(int n) { _fraigThreads = (n<1 ? 1 : n); }
+   //cone gates per pair and seconds per fraig, 0 for no limit
+   void setFraigBudget(size_t pairGates, double sec) {
+	   _pairBudget = pairGates; _timeBudget = sec;
+   }
+   //proofs are looked up in and added to fileName, "" for none
+   void setProofCache(const string &fileName) { _proofCache.open(fileName); }
+   void printFraigStat() const;
 
    // Member functions about circuit reporting
    void printSummary() const;
-   void printNetlist() const;
+   //redo a spliced DFS order first, see canonDfs()
+   void printNetlist();
    void printPIs() const;
    void printPOs() const;
    void printFloatGates() const;
    void printFECPairs() const;
-   void writeAag(ostream&) const;
+   void printMemUsage() const;
+   void writeAag(ostream&);
+   void writeAig(ostream&);
    void writeGate(ostream&, CirGate*) const;
 
 private:
@@ -71,33 +93,54 @@ private:
    bool readAIG(ifstream &fin);
    bool readSym(ifstream &fin);
    bool readComment(ifstream &fin);
+   bool readBinary(const string &fileName);
+   bool readParallel(const string &fileName);
+   bool readHeader(const char *&cur, const char *end);
+   bool readInput(const char *&cur, const char *end);
+   bool readOutput(const char *&cur, const char *end);
+   bool readBinaryIO(const char *&cur, const char *end);
+   bool readBinaryAIG(const char *&cur, const char *end);
+   bool readAIGParallel(const char *&cur, const char *end);
+   bool readSym(const char *&cur, const char *end);
+   static const char* mapFile(const string &fileName, size_t &len);
    void connect();
+   void connectParallel();
    void dfs();
+   void dfsOrder(const GateList &roots, GateList &order, 
+		vector<unsigned> *level=NULL) const;
    
    //private Member functions about optimization
    void resetFloat(bool cirsw = false);
    void resetUnuse();
    void resetDfs();
+   void updateDfs();
+   void spliceDfs(CirGate *delGate, CirGate *merGate);
+   void canonDfs();
    void mergeGate(CirGate* delGate, CirGate *merGate,int propPhase=-1);
 
    //private Member functions about simulation
-   void randSig();
-   int readSig(ifstream &fin);
-   void simulate();
+   size_t piWord(int i, bool biased);
+   void learnBias();
+   void simPatterns(PatternSource &src);
+   void simulate(unsigned nw=0);
+   bool resimulate();
    void CreateFirstFEC();
-   bool IdentifyFEC();
-   void writeSim(int num);
-   void setFirstFgp() const;
+   bool IdentifyFEC(unsigned w=0);
+   bool IdentifyFEC(const IdList &changed);
+   void writeSim(int num, unsigned w=0);
    void SortFEC(bool dfs);
    void resetFEC();
    
    //private Member functions about fraig
-   void genProofModel(SatSolver& s);
-   bool ProvePair(SatSolver &solver,int id0,bool ph0,int id1,bool ph1);
-   void collectPattern(SatSolver &solver,int numSig);
+   void collectPattern(int numSig, const vector<char> &cex);
+   void resimCex(int numSig);
 
    //private Member variable
    ofstream           *_simLog; 
+   CirSimLog          _log; //buffered writer on _simLog
+   int                _numThreads; //1 unless set by setThreadNum
+   bool               _dfsDirty; //_dfsList needs a full resetDfs
+   bool               _dfsSpliced; //_dfsList is not the fresh DFS order
    int M,I,L,O,A,Aw; //Aw is for write operation
    static CirGate 		*_const0;
    vector<CirPiGate*> 	_piList;
@@ -107,7 +150,28 @@ private:
    vector<CirGate*>		_unuseList;
    vector<CirGate*>		_dfsList;
    vector <size_t> 		_sigList;
-   vector<FECgroup*>	_fecGrps;
+   SimRng				_rng; //pattern generator
+   vector<signed char>	_piBias; //>0 favors 1, <0 favors 0
+   bool					_coneSim; //simulate FEC candidate cones only
+   size_t				_coneLits; //_fec.numLits() when the cone was built
+   CirFec				_fec; //FEC groups
+   vector<char>			_fecMark; //changed gates, scratch of IdentifyFEC
+   CirAig				_aig; //flat copy of fanins & signals
+   CirArena				_arena; //storage of gates & edges
+   CirFanout			_fanout; //fanouts of every gate
+   bool					_cexExpand; //distance-1 flips of each cex
+   int					_fraigThreads;
+   size_t				_pairBudget; //cone gates, 0 = unlimited
+   double				_timeBudget; //seconds, 0 = unlimited
+   size_t				_satCalls, _satCex, _cexRounds; //of the last fraig
+   double				_fraigSec;
+   size_t				_cnfVars, _cnfGates; //encoded by the last fraig
+   size_t				_satRebuilds;
+   size_t				_simCalls, _simCex; //pairs decided by exhaustive sim
+   CirProofCache		_proofCache;
+   size_t				_cacheLookups, _cacheHits; //of the last fraig
+   size_t				_fraigProven, _fraigDisproven; //pairs, by any means
+   size_t				_fraigUndecided; //candidates left by the last fraig
 };
 
 #endif // CIR_MGR_H
@@ -38,7 +38,7 @@ CirMgr::sweep()
 			&& g->getType()!=CONST_GATE){
 			if(g->getType()==AIG_GATE) A--;
 			cout<<"Sweeping: "<<g->getTypeStr()<<"("<<i<<") removed..."<<endl;
-			delete _gateList[i]; _gateList[i]=NULL;
+			_gateList[i]->~CirGate(); _gateList[i]=NULL;
 		}
 	}
 	resetFloat(true);
@@ -56,13 +56,14 @@ CirMgr::optimize()
 	CirGate  *g;
 	OptCase optcase;
 	size_t id0,ph0,id1,ph1; //fanin id & phase
+	const IdList &order = _aig.order();
 
-	for(int i=0;i<_dfsList.size();++i){
-		g = _dfsList[i];
+	for(int i=0;i<order.size();++i){
+		g = _gateList[order[i]];
 		//optGate(g,true);
-		if(g->FaninSize()==2){	
-			id0 = g->getFaninGateID(0); ph0 = g->getFaninGatePhase(0);
-			id1 = g->getFaninGateID(1); ph1 = g->getFaninGatePhase(1);
+		if(_aig.type(order[i])==AIG_GATE){	
+			id0 = _aig.fanin(order[i],0)/2; ph0 = _aig.fanin(order[i],0)%2;
+			id1 = _aig.fanin(order[i],1)/2; ph1 = _aig.fanin(order[i],1)%2;
 			
 			if(id0==id1){ 
 				if(ph0==ph1) optcase = IDENTICAL;
@@ -95,7 +96,7 @@ CirMgr::optimize()
 		}
 	}
 	resetFloat();
-	resetDfs();
+	updateDfs();
 	resetUnuse();
 	resetFEC();
 }
@@ -106,20 +107,14 @@ CirMgr::optimize()
 void
 CirMgr::resetFloat(bool cirsw){
 	_floatList.clear();
-	if(cirsw){
-		for(int i=0;i<_gateList.size();++i){
-			CirGate  *g = _gateList[i];
-			if(g!=NULL && g->getType()!=PO_GATE)
-				g->clearFanout();
-		}
-	}
+	//fanouts of swept gates are dropped by rebuilding the whole index
+	if(cirsw) _fanout.build(_gateList,_numThreads);
 	for(int i=0;i<_gateList.size();i++){
 		CirGate  *g = _gateList[i];
 		if(g==NULL) continue;
 		if(g->getType()==PO_GATE || g->getType()==AIG_GATE){
 			for(int j=0;j<g->FaninSize();j++){
 				size_t id = g->getFaninGateID(j);
-				size_t phase = g->getFaninGatePhase(j);
 				//floating case: b,c,d
 				assert(id< _gateList.size());
 				assert(_gateList[id]!=NULL);
@@ -127,8 +122,6 @@ CirMgr::resetFloat(bool cirsw){
 					if(_floatList.empty()||_floatList.back()!=g)
 						_floatList.push_back(g);//prevent repeat
 				}
-				//even undefined gate has to set fanout & fanin
-				if(cirsw) _gateList[id] -> setFanout(g,phase);
 			}
 		}
 	}
@@ -155,8 +148,88 @@ CirMgr::resetDfs(){
 		}
 	}
 	_dfsList.clear(); 
+	_dfsDirty = false;
 	dfs();
 }
+//Drop the entries spliced out by mergeGate and renumber, a full
+//resetDfs is only done if a merge could not be spliced in place
+void
+CirMgr::updateDfs(){
+	if(_dfsDirty){
+		resetDfs();
+		return;
+	}
+	size_t n=0; Aw=0;
+	for(size_t i=0;i<_dfsList.size();i++){
+		CirGate *g = _dfsList[i];
+		if(g==NULL) continue;
+		g->setDfsNum(n);
+		if(g->getType()==AIG_GATE) Aw++;
+		_dfsList[n++] = g;
+	}
+	_dfsList.resize(n);
+	_aig.setOrder(_dfsList);
+}
+//A spliced order is topological, but netlists and written files follow
+//the order of a fresh DFS, so it is redone before they are printed. Only
+//the listing changes: _aig keeps its (equally valid) order and signals.
+void
+CirMgr::canonDfs()
+{
+	if(!_dfsSpliced) return;
+	GateList roots(_poList.begin(),_poList.end());
+	_dfsList.clear();
+	dfsOrder(roots,_dfsList);
+	Aw = 0;
+	for(size_t i=0;i<_dfsList.size();i++){
+		_dfsList[i]->setDfsNum(i);
+		if(_dfsList[i]->getType()==AIG_GATE) Aw++;
+	}
+	_dfsSpliced = false;
+}
+//delGate's fanouts are already on merGate. Its slot in _dfsList is
+//cleared, and fanins left without a reachable fanout are taken out of
+//the order (and their fanins in turn). merGate comes before every
+//fanout of delGate in strash, optimize and fraig, so the order stays
+//topological. A faninless merGate not yet listed (CONST0) takes the
+//freed slot; any other unlisted merGate needs a full resetDfs.
+void
+CirMgr::spliceDfs(CirGate *delGate, CirGate *merGate){
+	int pos = delGate->getDfsNum();
+	if(pos==-1) return; //unreachable, so were its fanouts
+	_dfsList[pos] = NULL;
+	_dfsSpliced = true;
+	delGate->setDfsNum(-1);
+	if(merGate->getDfsNum()==-1 && merGate->getType()!=UNDEF_GATE){
+		if(merGate->FaninSize()==0){
+			_dfsList[pos] = merGate;
+			merGate->setDfsNum(pos);
+		}
+		else _dfsDirty = true;
+	}
+
+	GateList stack;
+	for(int i=0;i<delGate->FaninSize();i++)
+		stack.push_back(_gateList[delGate->getFaninGateID(i)]);
+	while(!stack.empty()){
+		CirGate *g = stack.back(); stack.pop_back();
+		if(g->getType()==UNDEF_GATE ? !g->getReach() : g->getDfsNum()==-1)
+			continue;
+		bool reach=false;
+		size_t id = g->getID();
+		for(unsigned k=_fanout.begin(id);k<_fanout.end(id) && !reach;k++){
+			if(!_fanout.dead(k))
+				reach = (_gateList[_fanout.gate(k)]->getDfsNum()!=-1);
+		}
+		if(reach) continue;
+		g->setReach(false);
+		if(g->getType()==UNDEF_GATE) continue;
+		_dfsList[g->getDfsNum()] = NULL;
+		g->setDfsNum(-1);
+		for(int i=0;i<g->FaninSize();i++)
+			stack.push_back(_gateList[g->getFaninGateID(i)]);
+	}
+}
 //merge delGate to merGate, delete delGate
 //if merGate is fanin of delGate, its fanout phase to delGate should be propagated
 void
@@ -165,25 +238,24 @@ CirMgr::mergeGate(CirGate* delGate, CirGate *merGate,int propPhase){
 	if(propPhase==1) cout<<"!";
 	cout<<delGate->getID()<<"..."<<endl;
 
-	size_t faninId;
-	for(int i=0;i<delGate->FaninSize();++i){
-		faninId = delGate->getFaninGateID(i);
-		_gateList[faninId] -> removeFanout(delGate->getID());
-	}
-	size_t id; bool ph; //delGate's fanout id & ph
-	for(int i=0;i<delGate->FanoutSize();++i){
-		id = delGate->getFanoutGateID(i); 
-		ph = delGate->getFanoutGatePhase(i);
-		if(propPhase!=-1){
-			_gateList[id]->replaceFanin(delGate->getID(),merGate,propPhase!=ph);
-			merGate->setFanout(_gateList[id],propPhase!=ph);
-		}
-		else{
-			_gateList[id]->replaceFanin(delGate->getID(),merGate,ph);
-			merGate->setFanout(_gateList[id],ph);
-		}
-	}
 	size_t gid = delGate->getID();
+	if(_fanout.needCompact()) _fanout.compact();
+	for(int i=0;i<delGate->FaninSize();++i)
+		_fanout.remove(delGate->getFaninGateID(i),gid,i);
+
+	//every fanout edge is redirected through its fanin slot
+	size_t id; int slot; bool ph; //delGate's fanout id, slot & ph
+	for(unsigned k=_fanout.begin(gid);k<_fanout.end(gid);++k){
+		if(_fanout.dead(k)) continue;
+		id = _fanout.gate(k); slot = _fanout.slot(k);
+		ph = _fanout.isInv(k);
+		if(propPhase!=-1) ph = (propPhase!=ph);
+		_gateList[id]->setFanin(merGate,ph,slot);
+		_aig.setFanin(id,slot,merGate->getID()*2+ph);
+		_fanout.add(merGate->getID(),id,slot,ph);
+	}
+	_fanout.clearRow(gid);
+	spliceDfs(delGate,merGate);
 	if(delGate->getType()==AIG_GATE) A--;
-	delete _gateList[gid]; _gateList[gid]=NULL;
+	_gateList[gid]->~CirGate(); _gateList[gid]=NULL;
 }
@@ -0,0 +1,96 @@
+/****************************************************************************
+  FileName     [ cirPool.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define persistent worker thread functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include "cirPool.h"
+
+using namespace std;
+
+//jobs of one run() left to finish
+struct CirPool::Task
+{
+	mutex                  mtx;
+	condition_variable     cv;
+	int                    left;
+};
+
+/**************************************/
+/*   class CirPool member functions   */
+/**************************************/
+CirPool&
+CirPool::instance()
+{
+	static CirPool pool;
+	return pool;
+}
+CirPool::~CirPool()
+{
+	for(size_t i=0;i<_workers.size();i++){
+		Worker *w = _workers[i];
+		{
+			lock_guard<mutex> lk(w->mtx);
+			w->stop = true;
+		}
+		w->cv.notify_one();
+		w->th.join();
+		delete w;
+	}
+}
+void
+CirPool::run(int T, const function<void(int)> &job)
+{
+	if(T<=1){ job(0); return; }
+	vector<Worker*> use;
+	{
+		lock_guard<mutex> lk(_mtx);
+		while(int(use.size())<T-1 && !_idle.empty()){
+			use.push_back(_idle.back());
+			_idle.pop_back();
+		}
+		while(int(use.size())<T-1){
+			Worker *w = new Worker;
+			w->job = NULL; w->task = NULL; w->stop = false;
+			w->th = thread(&CirPool::loop,this,w);
+			_workers.push_back(w);
+			use.push_back(w);
+		}
+	}
+	Task task;
+	task.left = T-1;
+	for(int t=1;t<T;t++){
+		Worker *w = use[t-1];
+		{
+			lock_guard<mutex> lk(w->mtx);
+			w->job = &job; w->idx = t; w->task = &task;
+		}
+		w->cv.notify_one();
+	}
+	job(0);
+	unique_lock<mutex> lk(task.mtx);
+	task.cv.wait(lk,[&task]{ return task.left==0; });
+}
+//a worker is back in _idle before its task is counted done, so the next
+//run() finds it
+void
+CirPool::loop(Worker *w)
+{
+	unique_lock<mutex> lk(w->mtx);
+	while(true){
+		w->cv.wait(lk,[w]{ return w->job!=NULL || w->stop; });
+		if(w->stop) return;
+		(*w->job)(w->idx);
+		Task *task = w->task;
+		w->job = NULL; w->task = NULL;
+		{
+			lock_guard<mutex> plk(_mtx);
+			_idle.push_back(w);
+		}
+		lock_guard<mutex> tlk(task->mtx);
+		if(--task->left==0) task->cv.notify_one();
+	}
+}
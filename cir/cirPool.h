@@ -0,0 +1,58 @@
+/****************************************************************************
+  FileName     [ cirPool.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define persistent worker threads ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_POOL_H
+#define CIR_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Threads started once and parked on a condition variable between jobs,
+// so a parallel step costs a wake-up instead of a thread start. run()
+// takes idle workers and starts more only if too few are idle, so a run
+// from inside another run (the log writer next to a simulation) works.
+class CirPool
+{
+public:
+   ~CirPool();
+   static CirPool& instance();
+
+   //job(1), ..., job(T-1) on workers, job(0) on the calling thread,
+   //returns when all are done
+   void run(int T, const function<void(int)> &job);
+   size_t numWorkers() const { return _workers.size(); }
+
+private:
+   struct Task;
+   struct Worker
+   {
+      thread                    th;
+      mutex                     mtx;
+      condition_variable        cv;
+      const function<void(int)> *job;
+      int                       idx;
+      Task                      *task;
+      bool                      stop;
+   };
+   CirPool() {}
+   void loop(Worker *w);
+
+   mutex                  _mtx;     //guards _workers and _idle
+   vector<Worker*>        _workers;
+   vector<Worker*>        _idle;
+};
+
+#endif // CIR_POOL_H
@@ -0,0 +1,89 @@
+/****************************************************************************
+  FileName     [ cirProofCache.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define on-disk cache of FEC pair proofs functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "cirProofCache.h"
+
+using namespace std;
+
+/**************************************/
+/*  class CirProofCache member funcs  */
+/**************************************/
+//malformed lines are skipped
+void
+CirProofCache::open(const string &fileName)
+{
+	_file = fileName;
+	_map.clear();
+	_dirty = false;
+	if(_file.empty()) return;
+	ifstream fin(_file.c_str());
+	string line, val;
+	while(getline(fin,line)){
+		istringstream is(line);
+		ProofKey key;
+		if(!(is>>hex>>key.h0>>key.h1>>val)) continue;
+		if(val!="=" && val[0]!='!') continue;
+		_map[key] = val;
+	}
+}
+//written to a temporary file renamed over the old one, so a crash or a
+//full disk leaves the previous cache intact
+bool
+CirProofCache::save()
+{
+	if(!enabled() || !_dirty) return true;
+	string tmp = _file+".tmp";
+	ofstream fout(tmp.c_str());
+	char buf[40];
+	for(auto it=_map.begin();it!=_map.end();it++){
+		snprintf(buf,sizeof(buf),"%016zx %016zx ",it->first.h0,it->first.h1);
+		fout<<buf<<it->second<<'\n';
+	}
+	fout.close();
+	if(!fout || rename(tmp.c_str(),_file.c_str())!=0){
+		remove(tmp.c_str());
+		return false;
+	}
+	_dirty = false;
+	return true;
+}
+bool
+CirProofCache::find(const ProofKey &key, const IdList &supp,
+	const vector<int> &piIdx, size_t numPi, ProofResult &res,
+	vector<char> &cex) const
+{
+	auto it = _map.find(key);
+	if(it==_map.end()) return false;
+	const string &c = it->second;
+	if(c[0]=='='){ res = PROOF_EQ; return true; }
+	//a stored cex of another length is a hash collision
+	if(c.size()!=supp.size()+1) return false;
+	res = PROOF_NEQ;
+	cex.assign(numPi,-1);
+	for(size_t j=0;j<supp.size();j++)
+		if(c[j+1]!='-') cex[piIdx[supp[j]]] = c[j+1]-'0';
+	return true;
+}
+void
+CirProofCache::insert(const ProofKey &key, const IdList &supp,
+	const vector<int> &piIdx, ProofResult res, const vector<char> &cex)
+{
+	assert(res!=PROOF_UNDECIDED);
+	string c(1, res==PROOF_EQ ? '=' : '!');
+	if(res==PROOF_NEQ)
+		for(size_t j=0;j<supp.size();j++){
+			char v = cex[piIdx[supp[j]]];
+			c += v<0 ? '-' : '0'+v;
+		}
+	_map[key] = c;
+	_dirty = true;
+}
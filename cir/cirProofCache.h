@@ -0,0 +1,62 @@
+/****************************************************************************
+  FileName     [ cirProofCache.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define on-disk cache of FEC pair proofs ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_PROOF_CACHE_H
+#define CIR_PROOF_CACHE_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "cirDef.h"
+#include "cirProver.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+struct ProofKeyHash
+{
+   size_t operator () (const ProofKey &k) const { return k.h0; }
+};
+
+// Proofs of FEC pairs kept across fraig runs, so unchanged parts of a
+// revised design are not proven again. Pairs are keyed by
+// CirProver::coneKey(); a disproved pair keeps its counterexample over
+// the key's PI order as '0', '1' or '-' (free). The file holds one pair
+// per line: "<h0> <h1> =" or "<h0> <h1> !<cex>", keys in hex.
+// find() may be called from several threads, insert() only when none is.
+class CirProofCache
+{
+public:
+   CirProofCache(): _dirty(false) {}
+   ~CirProofCache() {}
+
+   //use fileName, "" for no cache. A missing file is an empty cache.
+   void open(const string &fileName);
+   //write the file back if pairs were added, false on a write error
+   bool save();
+   bool enabled() const { return !_file.empty(); }
+   size_t size() const { return _map.size(); }
+
+   //result of the pair with support supp; cex as from
+   //CirProver::getCex, piIdx maps a PI id to its index there
+   bool find(const ProofKey &key, const IdList &supp,
+		const vector<int> &piIdx, size_t numPi,
+		ProofResult &res, vector<char> &cex) const;
+   void insert(const ProofKey &key, const IdList &supp,
+		const vector<int> &piIdx, ProofResult res,
+		const vector<char> &cex);
+
+private:
+   string                 _file;
+   unordered_map<ProofKey,string,ProofKeyHash> _map; //"=" or "!<cex>"
+   bool                   _dirty;
+};
+
+#endif // CIR_PROOF_CACHE_H
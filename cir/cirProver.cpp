@@ -0,0 +1,406 @@
+/****************************************************************************
+  FileName     [ cirProver.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define SAT prover functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "cirProver.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+//dead clauses before the solver may be rebuilt
+#define SAT_RECYCLE (1<<14)
+//word of PI j<6 in the exhaustive patterns: bit b holds bit j of b
+static const size_t simMask[6] = {
+	0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+	0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+//independent seeds of the two halves of a ProofKey
+static const size_t keySeed[2] = {
+	0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL
+};
+
+//order-sensitive combination of a and b through the splitmix64 finalizer
+static inline size_t
+keyMix(size_t a, size_t b)
+{
+	size_t x = a*0x9E3779B97F4A7C15ULL ^ (b+0x632BE59BD9B4E019ULL);
+	x ^= x>>30; x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x>>27; x *= 0x94D049BB133111EBULL;
+	return x ^ (x>>31);
+}
+
+/**************************************/
+/*   class CirProver member functions */
+/**************************************/
+//fresh solver with only CONST0 encoded
+void
+CirProver::reset(const CirAig &aig)
+{
+	_solver.initialize();
+	_var.assign(aig.size(),0);
+	_mark.assign(aig.size(),0);
+	Var v = _solver.newVar();
+	_var[0] = v;
+	_solver.addAigCNF(v,v,true,v,false);
+	_mark[0] = 1;
+	_vars++;
+	_cls = 1; _dead = 0;
+}
+//add the not yet encoded part of the fanin cone of id, fanins first.
+//Undefined gates simulate as 0 and share the CONST0 variable.
+void
+CirProver::encodeCone(const CirAig &aig, unsigned id)
+{
+	if(_mark[id]) return;
+	vector<pair<unsigned,bool> > stack(1,make_pair(id,false));
+	while(!stack.empty()){
+		unsigned g = stack.back().first; bool ready = stack.back().second;
+		stack.pop_back();
+		if(_mark[g]) continue;
+		unsigned f0 = aig.fanin(g,0), f1 = aig.fanin(g,1);
+		switch(aig.type(g)){
+			case AIG_GATE:
+				if(!ready){
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f0/2,false));
+					stack.push_back(make_pair(f1/2,false));
+					continue;
+				}
+				_var[g] = _solver.newVar();
+				_solver.addAigCNF(_var[g],_var[f0/2],f0%2,_var[f1/2],f1%2);
+				_vars++; _gates++; _cls+=3;
+				break;
+			case PI_GATE:
+				_var[g] = _solver.newVar();
+				_vars++;
+				break;
+			case PO_GATE:
+				if(!ready){
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f0/2,false));
+					continue;
+				}
+				_var[g] = _var[f0/2];
+				break;
+			default:
+				_var[g] = _var[0];
+				break;
+		}
+		_mark[g] = 1;
+	}
+}
+ProofResult
+CirProver::prove(const CirAig &aig, unsigned id0, bool ph0, unsigned id1,
+	bool ph1, size_t budget)
+{
+	size_t n = markCone(aig,id0,id1);
+	//simulation costs a pass over the cone per word, a budget on that
+	//hands the pair to SAT
+	if(_supp.size()<=SIM_SUPPORT){
+		size_t nw = _supp.size()<=6 ? 1 : size_t(1)<<(_supp.size()-6);
+		if(!budget || nw*n<=budget) return simProve(aig,id0,ph0,id1,ph1);
+	}
+	if(budget && n>budget) return PROOF_UNDECIDED;
+	_simHit = false;
+	if(_dead>SAT_RECYCLE && 2*_dead>_cls){
+		reset(aig);
+		_rebuilds++;
+	}
+	encodeCone(aig,id0);
+	encodeCone(aig,id1);
+	Var newV = _solver.newVar();
+	_solver.addXorCNF(newV,_var[id0],ph0,_var[id1],ph1);
+	//the miter is guarded by act: g = act & newV is assumed, and act is
+	//asserted false once the pair is decided, which satisfies the guard
+	//clauses whatever the result
+	Var act = _solver.newVar(), g = _solver.newVar();
+	_solver.addAigCNF(g,act,false,newV,false);
+	_vars+=3; _cls+=7;
+
+	//four types of FEC pair
+	//solver.addXorCNF(vf, va, fa, vb, fb)
+	//	 a, b ->  a!= b, (fa=0,fb=0), unsat means  a == b, merge( a, b,0)
+	//	 a,!b ->  a!=!b, (fa=0,fb=1), unsat means  a ==!b, merge( a,!b,1)
+	//	!a, b -> !a!= b, (fa=1,fb=0), unsat means !a == b, merge(!a, b,1)
+	//	!a,!b -> !a!=!b, (fa=1,fb=1), unsat means !a ==!b, merge(!a,!b,0)
+
+	_solver.assumeRelease();
+	_solver.assumeProperty(g,true);
+	bool result = _solver.assumpSolve();
+	_calls++;
+	_solver.assertProperty(act,false);
+	_dead+=3;
+	//an equivalent pair keeps its XOR clauses as a == b
+	if(result){ _sat++; _dead+=4; }
+	else _solver.assertProperty(newV,false);
+	return result ? PROOF_NEQ : PROOF_EQ;
+}
+//stamp the fanin cones of id0 and id1 with a new _coneGen and collect
+//their PIs in _supp, returns the number of gates stamped
+size_t
+CirProver::markCone(const CirAig &aig, unsigned id0, unsigned id1)
+{
+	if(_cone.size()<aig.size()) _cone.resize(aig.size(),0);
+	if(++_coneGen==0){
+		fill(_cone.begin(),_cone.end(),0);
+		_coneGen=1;
+	}
+	size_t n=0;
+	IdList stack;
+	_supp.clear();
+	stack.push_back(id0); stack.push_back(id1);
+	while(!stack.empty()){
+		unsigned id = stack.back();
+		stack.pop_back();
+		if(_cone[id]==_coneGen) continue;
+		_cone[id] = _coneGen;
+		n++;
+		switch(aig.type(id)){
+			case AIG_GATE:
+				stack.push_back(aig.fanin(id,1)>>1); //fall through
+			case PO_GATE:
+				stack.push_back(aig.fanin(id,0)>>1);
+				break;
+			case PI_GATE:
+				_supp.push_back(id);
+				break;
+			default:
+				break;
+		}
+	}
+	return n;
+}
+void
+CirProver::getCex(const CirAig &aig, unsigned id0, unsigned id1,
+	const IdList &pis, vector<char> &cex)
+{
+	markCone(aig,id0,id1);
+	cex.assign(pis.size(),-1);
+	if(_simHit){
+		//PI j of the support is bit j of the pattern's index
+		if(_pos.size()<aig.size()) _pos.resize(aig.size(),~0U);
+		for(unsigned j=0;j<_supp.size();j++) _pos[_supp[j]] = j;
+		for(size_t i=0;i<pis.size();i++){
+			if(_cone[pis[i]]!=_coneGen) continue;
+			unsigned j = _pos[pis[i]];
+			cex[i] = j<6 ? (_simB>>j)&1 : (_simW>>(j-6))&1;
+		}
+		for(unsigned j=0;j<_supp.size();j++) _pos[_supp[j]] = ~0U;
+		return;
+	}
+	for(size_t i=0;i<pis.size();i++){
+		//a PI only reached through fanins changed by merges is free
+		if(_cone[pis[i]]!=_coneGen || !_mark[pis[i]]) continue;
+		int a = _solver.getValue(_var[pis[i]]);
+		assert(a==0 || a==1);
+		cex[i] = a;
+	}
+}
+//decide the pair on every assignment of the _supp PIs left by markCone:
+//PI j<6 takes the bits of simMask[j], PI j>=6 bit j-6 of the word index
+ProofResult
+CirProver::simProve(const CirAig &aig, unsigned id0, bool ph0, unsigned id1,
+	bool ph1)
+{
+	_simCalls++;
+	if(_pos.size()<aig.size()) _pos.resize(aig.size(),~0U);
+	for(unsigned j=0;j<_supp.size();j++) _pos[_supp[j]] = j;
+	//fanins first, PIs keep their support index in _pos
+	_order.clear();
+	vector<pair<unsigned,bool> > stack;
+	stack.push_back(make_pair(id1,false));
+	stack.push_back(make_pair(id0,false));
+	while(!stack.empty()){
+		unsigned g = stack.back().first; bool ready = stack.back().second;
+		stack.pop_back();
+		if(aig.type(g)==PI_GATE) continue;
+		if(_pos[g]!=~0U) continue;
+		if(!ready && (aig.type(g)==AIG_GATE || aig.type(g)==PO_GATE)){
+			stack.push_back(make_pair(g,true));
+			stack.push_back(make_pair(aig.fanin(g,0)/2,false));
+			if(aig.type(g)==AIG_GATE)
+				stack.push_back(make_pair(aig.fanin(g,1)/2,false));
+			continue;
+		}
+		_pos[g] = _order.size();
+		_order.push_back(g);
+	}
+	_val.resize(_order.size());
+	//value word of fanin literal f, on word w of the patterns
+	auto litVal = [&](unsigned f, size_t w){
+		unsigned g = f/2;
+		size_t v;
+		if(aig.type(g)!=PI_GATE) v = _val[_pos[g]];
+		else if(_pos[g]<6) v = simMask[_pos[g]];
+		else v = (w>>(_pos[g]-6))&1 ? ~size_t(0) : 0;
+		return (f&1) ? ~v : v;
+	};
+	size_t nw = _supp.size()<=6 ? 1 : size_t(1)<<(_supp.size()-6);
+	ProofResult res = PROOF_EQ;
+	for(size_t w=0;w<nw && res==PROOF_EQ;w++){
+		for(size_t i=0;i<_order.size();i++){
+			unsigned g = _order[i];
+			switch(aig.type(g)){
+				case AIG_GATE:
+					_val[i] = litVal(aig.fanin(g,0),w) & litVal(aig.fanin(g,1),w);
+					break;
+				case PO_GATE:
+					_val[i] = litVal(aig.fanin(g,0),w);
+					break;
+				default:
+					_val[i] = 0;
+					break;
+			}
+		}
+		size_t diff = litVal(2*id0+ph0,w) ^ litVal(2*id1+ph1,w);
+		if(diff){
+			res = PROOF_NEQ;
+			_simW = w; _simB = __builtin_ctzll(diff);
+		}
+	}
+	for(size_t i=0;i<_order.size();i++) _pos[_order[i]] = ~0U;
+	for(unsigned j=0;j<_supp.size();j++) _pos[_supp[j]] = ~0U;
+	_simHit = (res==PROOF_NEQ);
+	if(_simHit) _simCex++;
+	return res;
+}
+//every node is hashed after its fanins from its type and its two fanin
+//literal hashes in sorted order, so commuted ANDs hash the same. A first
+//pass hashes the cones with all PIs alike; the second numbers the PIs by
+//first visit, taking the fanin of smaller PI-blind hash first, and hashes
+//with the PI numbers. Fanins that still tie may get their PIs numbered
+//either way, which can only cost a cache hit. Undefined gates hash as
+//CONST0 since both simulate as 0.
+ProofKey
+CirProver::coneKey(const CirAig &aig, unsigned id0, bool ph0, unsigned id1,
+	bool ph1, IdList &supp)
+{
+	if(_pos.size()<aig.size()) _pos.resize(aig.size(),~0U);
+	supp.clear(); _order.clear(); _shape.clear();
+	//PI-blind hash of literal f
+	auto litShape = [&](unsigned f){
+		size_t v = _shape[_pos[f/2]];
+		return (f&1) ? keyMix(v,1) : v;
+	};
+	//half k of the hash of literal f
+	auto litHash = [&](unsigned f, int k){
+		const ProofKey &h = _hash[_pos[f/2]];
+		size_t v = k ? h.h1 : h.h0;
+		return (f&1) ? keyMix(v,1) : v;
+	};
+	vector<pair<unsigned,bool> > stack;
+	stack.push_back(make_pair(id1,false));
+	stack.push_back(make_pair(id0,false));
+	while(!stack.empty()){
+		unsigned g = stack.back().first; bool ready = stack.back().second;
+		stack.pop_back();
+		if(_pos[g]!=~0U) continue;
+		unsigned f0 = aig.fanin(g,0), f1 = aig.fanin(g,1);
+		size_t h;
+		switch(aig.type(g)){
+			case AIG_GATE:
+				if(!ready){
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f1/2,false));
+					stack.push_back(make_pair(f0/2,false));
+					continue;
+				}
+				h = keyMix(keyMix(keySeed[0]^2,min(litShape(f0),litShape(f1))),
+					max(litShape(f0),litShape(f1)));
+				break;
+			case PO_GATE:
+				if(!ready){
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f0/2,false));
+					continue;
+				}
+				h = keyMix(keySeed[0]^3,litShape(f0));
+				break;
+			case PI_GATE:
+				h = keyMix(keySeed[0]^1,0);
+				break;
+			default:
+				h = keyMix(keySeed[0],0);
+				break;
+		}
+		_pos[g] = _order.size();
+		_order.push_back(g);
+		_shape.push_back(h);
+	}
+	//PIs and equal subcones are told apart by where they are used: each
+	//gate adds its fanout's hash to its own, then the fanin of smaller
+	//hash is visited first
+	_hash.assign(_order.size(),ProofKey());
+	_hash[_pos[id0]].h0 += keyMix(keySeed[0]^5,ph0);
+	_hash[_pos[id1]].h0 += keyMix(keySeed[0]^6,ph1);
+	for(size_t i=0;i<_order.size();i++){
+		unsigned g = _order[i];
+		if(aig.type(g)!=AIG_GATE && aig.type(g)!=PO_GATE) continue;
+		for(int j=0;j<(aig.type(g)==AIG_GATE ? 2 : 1);j++){
+			unsigned f = aig.fanin(g,j);
+			_hash[_pos[f/2]].h0 += keyMix(_shape[i],f&1);
+		}
+	}
+	for(size_t i=0;i<_order.size();i++)
+		_shape[i] = keyMix(_shape[i],_hash[i].h0);
+	_hash.assign(_order.size(),ProofKey());
+	_done.assign(_order.size(),0);
+	stack.push_back(make_pair(id1,false));
+	stack.push_back(make_pair(id0,false));
+	while(!stack.empty()){
+		unsigned g = stack.back().first; bool ready = stack.back().second;
+		stack.pop_back();
+		if(_done[_pos[g]]) continue;
+		unsigned f0 = aig.fanin(g,0), f1 = aig.fanin(g,1);
+		size_t h[2];
+		switch(aig.type(g)){
+			case AIG_GATE:
+				if(!ready){
+					if(litShape(f1)<litShape(f0)) swap(f0,f1);
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f1/2,false));
+					stack.push_back(make_pair(f0/2,false));
+					continue;
+				}
+				for(int k=0;k<2;k++)
+					h[k] = keyMix(keyMix(keySeed[k]^2,
+						min(litHash(f0,k),litHash(f1,k))),
+						max(litHash(f0,k),litHash(f1,k)));
+				break;
+			case PO_GATE:
+				if(!ready){
+					stack.push_back(make_pair(g,true));
+					stack.push_back(make_pair(f0/2,false));
+					continue;
+				}
+				for(int k=0;k<2;k++) h[k] = keyMix(keySeed[k]^3,litHash(f0,k));
+				break;
+			case PI_GATE:
+				for(int k=0;k<2;k++) h[k] = keyMix(keySeed[k]^1,supp.size());
+				supp.push_back(g);
+				break;
+			default:
+				for(int k=0;k<2;k++) h[k] = keyMix(keySeed[k],0);
+				break;
+		}
+		ProofKey key = {h[0],h[1]};
+		_hash[_pos[g]] = key;
+		_done[_pos[g]] = 1;
+	}
+	size_t h[2];
+	for(int k=0;k<2;k++)
+		h[k] = keyMix(keyMix(keySeed[k]^4,litHash(2*id0+ph0,k)),
+			litHash(2*id1+ph1,k));
+	for(size_t i=0;i<_order.size();i++) _pos[_order[i]] = ~0U;
+	ProofKey key = {h[0],h[1]};
+	return key;
+}
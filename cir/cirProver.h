@@ -0,0 +1,124 @@
+/****************************************************************************
+  FileName     [ cirProver.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define SAT prover for FEC pairs ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_PROVER_H
+#define CIR_PROVER_H
+
+#include <vector>
+#include "cirDef.h"
+#include "cirAig.h"
+#include "sat.h"
+
+using namespace std;
+
+//largest support decided by exhaustive simulation, 2^10 words
+#define SIM_SUPPORT 16
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+enum ProofResult
+{
+   PROOF_EQ        = 0,
+   PROOF_NEQ       = 1,
+   PROOF_UNDECIDED = 2
+};
+
+//128-bit structural hash of a pair's fanin cones, see CirProver::coneKey
+struct ProofKey
+{
+   size_t h0, h1;
+   bool operator == (const ProofKey &k) const { return h0==k.h0 && h1==k.h1; }
+};
+
+//FEC pair handed to a prover, with its result
+struct FraigPair
+{
+   unsigned id0, id1;
+   bool ph0, ph1;
+   ProofResult res;
+   vector<char> cex; //per PI, see CirProver::getCex
+   ProofKey key;     //filled only when a proof cache is used
+   IdList supp;      //PIs of the cones in key order
+   bool cached;      //res and cex came from the proof cache
+};
+
+// One SatSolver with its own gate -> variable map. Cones are encoded on
+// demand from the CirAig fanins, so several provers can work on the same
+// (unchanging) circuit from different threads. The miter of a pair is
+// guarded by an activation variable, assumed only during its own call and
+// asserted false once the pair is decided; the miter itself is asserted
+// false if the pair is equivalent. Guards, clauses of refuted miters and
+// of merged gates are dead; once most are dead the solver is rebuilt.
+// A pair whose cones depend on at most SIM_SUPPORT PIs is decided by
+// simulating all their input combinations instead, without CNF, unless
+// the words times the cone size exceed the cone budget.
+class CirProver
+{
+public:
+   CirProver(): _coneGen(0), _simHit(false), _vars(0), _gates(0),
+	   _calls(0), _sat(0), _rebuilds(0), _simCalls(0), _simCex(0) {}
+   ~CirProver() {}
+
+   void reset(const CirAig &aig);
+   //SatSolver has no conflict limit, so the budget is on the size of the
+   //pair's fanin cones (0 = none): larger pairs are left undecided
+   ProofResult prove(const CirAig &aig, unsigned id0, bool ph0,
+		unsigned id1, bool ph1, size_t budget=0);
+   //after PROOF_NEQ: cex[i] is the value of PI pis[i] in the model,
+   //-1 if it is outside the fanin cones of the pair
+   void getCex(const CirAig &aig, unsigned id0, unsigned id1,
+		const IdList &pis, vector<char> &cex);
+   //hash of the cones of (id0,ph0) and (id1,ph1) in which the PIs are
+   //numbered by first visit; supp gets them in that order. Equal keys
+   //mean equal structure up to the PI and gate numbering and the order
+   //of AND fanins.
+   ProofKey coneKey(const CirAig &aig, unsigned id0, bool ph0,
+		unsigned id1, bool ph1, IdList &supp);
+   //gate id was merged away, its clauses are dead
+   void merged(unsigned id) { if(_mark[id]) _dead+=3; }
+
+   //statistics
+   size_t vars() const { return _vars; }
+   size_t gates() const { return _gates; }
+   size_t calls() const { return _calls; }
+   size_t satCalls() const { return _sat; }
+   size_t rebuilds() const { return _rebuilds; }
+   size_t simCalls() const { return _simCalls; }
+   size_t simCex() const { return _simCex; }
+
+private:
+   void encodeCone(const CirAig &aig, unsigned id);
+   size_t markCone(const CirAig &aig, unsigned id0, unsigned id1);
+   ProofResult simProve(const CirAig &aig, unsigned id0, bool ph0,
+		unsigned id1, bool ph1);
+
+   SatSolver              _solver;
+   vector<Var>            _var;
+   vector<char>           _mark; //gate has a variable
+   vector<unsigned>       _cone; //== _coneGen inside the last cex cone
+   unsigned               _coneGen;
+   IdList                 _supp;  //PIs of the last cone, in DFS order
+   //scratch for simProve(): the cone in topological order, positions in
+   //it (~0 outside) and one word of values per gate
+   IdList                 _order;
+   vector<unsigned>       _pos;
+   vector<size_t>         _val;
+   //scratch for coneKey(), by _order index: the hash with numbered PIs,
+   //the PI-blind hash with its uses, and whether the first is done
+   vector<ProofKey>       _hash;
+   vector<size_t>         _shape;
+   vector<char>           _done;
+   bool                   _simHit; //last NEQ came from simProve()
+   size_t                 _simW, _simB; //its pattern: word and bit
+   size_t                 _cls, _dead; //clauses in the solver, dead ones
+   size_t                 _vars, _gates, _calls, _sat, _rebuilds;
+   size_t                 _simCalls, _simCex;
+};
+
+#endif // CIR_PROVER_H
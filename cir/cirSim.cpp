@@ -14,8 +14,11 @@
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
-#include <unordered_map>
 #include <queue>
+#include <chrono>
+#include <sstream>
+#include <cstring>
+#include <sys/mman.h>
 using namespace std;
 
 /*******************************/
@@ -23,20 +26,14 @@ using namespace std;
 /*******************************/
 
 
-class FecListSort{
-public:
-	bool operator()(const FECgroup *fgp0, const FECgroup *fgp1)const{
-		int id0 = fgp0->at(0)/2; 
-		int id1 = fgp1->at(0)/2;
-		return 	fgp0->size() < fgp1->size() || id0<id1;
-	}
-};
-
+//CONST0 first, it has to stay the representative of its group, then
+//DFS order
 class FecGrpSort{
 public:
-	bool operator()(const int g0, const int g1)const{
+	bool operator()(const unsigned g0, const unsigned g1)const{
 		int id0 = g0/2; 
 		int id1 = g1/2;		
+		if(id0==0 || id1==0) return id0==0 && id1!=0;
 		return cirMgr-> _gateList[id0]->getDfsNum() < 
 			   cirMgr-> _gateList[id1]->getDfsNum();
 	}				
@@ -46,27 +43,196 @@ public:
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+//rounds without progress before randomSim stops
+#define SIM_WINDOW 16
+
+//8 chars are all '0'/'1'
+static inline bool
+isBits8(size_t x){
+	return (x & ~0x0101010101010101ULL) == 0x3030303030303030ULL;
+}
+//pack '0'/'1' chars into bits, bit i of row[i/64] is p[i]. Returns the
+//position of the first other character, len if there is none
+static size_t
+packBits(const char *p, size_t len, size_t *row){
+	size_t i=0;
+	for(size_t c=0;c<(len+63)/64;c++) row[c]=0;
+	for(;i+8<=len;i+=8){
+		size_t x;
+		memcpy(&x,p+i,8);
+		if(!isBits8(x)) break;
+		//gather the low bit of each byte, byte b -> bit b
+		row[i/64] |= (((x & 0x0101010101010101ULL)*0x0102040810204080ULL)>>56)<<(i%64);
+	}
+	for(;i<len;i++){
+		if(p[i]!='0' && p[i]!='1') return i;
+		row[i/64] |= size_t(p[i]-'0')<<(i%64);
+	}
+	return len;
+}
+
+//stream chunk read at once by PatternSource
+#define PAT_CHUNK (size_t(1)<<20)
+
+//whitespace separated patterns from a mapped file, or from a stream read
+//in chunks into the same kind of buffer, so both take the same scanner
+class PatternSource
+{
+public:
+	PatternSource(const char *b, const char *e):
+		_bgn(b), _cur(b), _end(e), _fin(NULL) {}
+	PatternSource(istream &fin): _bgn(NULL), _cur(NULL), _end(NULL),
+		_fin(&fin), _start(fin.tellg()) {}
+	//next token, false at the end of input
+	bool next(const char *&p, size_t &len){
+		while(true){
+			while(_cur<_end && isspace((unsigned char)*_cur)) ++_cur;
+			if(_cur<_end) break;
+			const char *keep=_cur;
+			if(!refill(keep)) return false;
+		}
+		p=_cur;
+		while(true){
+			//skip 0/1 runs 8 bytes at a time
+			size_t x;
+			while(_cur+8<=_end){
+				memcpy(&x,_cur,8);
+				if(!isBits8(x)) break;
+				_cur+=8;
+			}
+			while(_cur<_end && !isspace((unsigned char)*_cur)) ++_cur;
+			//a token cut by the chunk end continues in the next chunk
+			if(_cur<_end || !refill(p)) break;
+		}
+		len=_cur-p;
+		return true;
+	}
+	//back to the first pattern, false if the stream can't seek
+	bool rewind(){
+		if(_fin==NULL){ _cur=_bgn; return true; }
+		_fin->clear();
+		_fin->seekg(_start);
+		_cur=_end=NULL;
+		return bool(*_fin);
+	}
+private:
+	//move [keep,_end) to the front of _buf and append the next chunk,
+	//keep then points to the moved bytes
+	bool refill(const char *&keep){
+		if(_fin==NULL || !*_fin) return false;
+		size_t k = _end-keep;
+		if(k) memmove(&_buf[0],keep,k);
+		if(_buf.size()<k+PAT_CHUNK) _buf.resize(k+PAT_CHUNK);
+		_fin->read(&_buf[k],PAT_CHUNK);
+		size_t got = _fin->gcount();
+		keep = &_buf[0];
+		_cur = keep+k; _end = _cur+got;
+		return got>0;
+	}
+	const char    *_bgn, *_cur, *_end;
+	istream       *_fin;
+	streampos      _start;
+	vector<char>   _buf;
+};
+
+//up to 64*W patterns transposed into PI words, word[j*W+w] is word w of
+//PI j. The 1st pattern of a word is its leftmost bit, missing ones are 0
+class PatternBlock
+{
+public:
+	PatternBlock(): num(0) {}
+	//false on a malformed pattern in the rest of src, message in err
+	bool check(PatternSource &src, size_t n){
+		bits.resize((n+63)/64);
+		const char *p; size_t len;
+		while(src.next(p,len))
+			if(!valid(p,len,n)) return false;
+		return true;
+	}
+	//false on a malformed pattern, message in err
+	bool read(PatternSource &src, size_t n, unsigned W){
+		size_t C = (n+63)/64;
+		word.assign(n*W,0); rows.resize(C*64); bits.resize(C);
+		num=0;
+		for(unsigned w=0;w<W;w++){
+			fill(rows.begin(),rows.end(),0);
+			int k=0;
+			const char *p; size_t len;
+			for(;k<64 && src.next(p,len);k++){
+				if(!valid(p,len,n)) return false;
+				//row 63-k so that pattern k ends up at bit 63-k
+				for(size_t c=0;c<C;c++) rows[c*64+63-k] = bits[c];
+			}
+			if(k==0) break;
+			for(size_t c=0;c<C;c++) transpose64(&rows[c*64]);
+			for(size_t j=0;j<n;j++) word[j*W+w] = rows[j];
+			num+=k;
+			if(k<64) break;
+		}
+		return true;
+	}
+	vector<size_t> word;
+	int            num;
+	string         err;
+private:
+	//pack pattern p into bits, false with err set if it is malformed
+	bool valid(const char *p, size_t len, size_t n){
+		if(len!=n){
+			ostringstream os;
+			os<<"Error: Pattern("<<string(p,len)<<") length("<<len
+			  <<") does not match the number of inputs("<<n
+			  <<") in a circuit!!";
+			err=os.str();
+			return false;
+		}
+		size_t bad = packBits(p,len,&bits[0]);
+		if(bad<len){
+			ostringstream os;
+			os<<"Error: Pattern("<<string(p,len)
+			  <<") contains a non-0/1 character(\'"<<p[bad]<<"\').";
+			err=os.str();
+			return false;
+		}
+		return true;
+	}
+	vector<size_t> rows, bits;
+};
 
 /************************************************/
 /*   Public member functions about Simulation   */
 /************************************************/
+//words alternate between uniform and per-PI biased patterns, the bias is
+//relearned every round. Stops once the last SIM_WINDOW rounds removed
+//less than 0.1% of the remaining candidates
 void
 CirMgr::randomSim()
 {
 	CreateFirstFEC();
-	int num=0, noNew=0; 
+	_rng.seed((size_t(rnGen(INT_MAX))<<32) ^ rnGen(INT_MAX));
+	_piBias.assign(_piList.size(),0);
+	int num=0; size_t k=0;
+	unsigned W = _aig.words();
+	vector<size_t> cand; //candidates left after each round
 	while(true){
-		randSig();
-		assert(_sigList.size()==_piList.size());
-		for(int i=0;i<_piList.size();i++)
-			_piList[i]->setSignal(_sigList[i]);
+		for(unsigned w=0;w<W;w++,k++){
+			for(int i=0;i<_piList.size();i++)
+				_aig.setSig(_piList[i]->getID(),piWord(i,k&1),w);
+		}
 		
-		num+=64;
-		simulate(); //simulate 64 pattern
-		if(_simLog!=NULL) writeSim(64); //write 64 pattern
-		if(!IdentifyFEC()) noNew++; 
-		if(noNew>_piList.size()*2)break;
+		num+=64*W;
+		simulate(); //simulate 64*W pattern
+		for(unsigned w=0;w<W;w++){
+			if(_simLog!=NULL) writeSim(64,w); //write 64 pattern
+			IdentifyFEC(w);
+		}
+		if(_fec.empty()) break;
+		cand.push_back(_fec.numLits()-_fec.size());
+		size_t r = cand.size();
+		if(r>SIM_WINDOW && cand[r-1-SIM_WINDOW]-cand[r-1] < 
+			max(cand[r-1]/1000,size_t(1))) break;
+		learnBias();
 	}
+	_log.flush();
 	cout<<num<<" patterns simulated."<<endl;
 	SortFEC(false);
 }
@@ -74,240 +240,307 @@ CirMgr::randomSim()
 void
 CirMgr::fileSim(ifstream& patternFile)
 {
-	CreateFirstFEC();
-	int num=readSig(patternFile);
-	cout<<num<<" patterns simulated."<<endl;
-
-	for(int i=0;i<_sigList.size();i++){
-		_piList[i%_piList.size()] -> setSignal(_sigList[i]);
-		if(i%_piList.size()==_piList.size()-1){
-			simulate(); //simulate 64 pattern
-			if(_simLog!=NULL && num>=64) writeSim(64); //write 64 pattern
-			else if(_simLog!=NULL && num<64) writeSim(num);
-			IdentifyFEC();
-			num-=64;
-		}
+	PatternSource src(patternFile);
+	simPatterns(src);
+}
+//mapped instead of read through a stream, false if it can't be opened
+bool
+CirMgr::fileSim(const string &fileName)
+{
+	size_t len;
+	const char *buf = mapFile(fileName,len);
+	if(buf==NULL){
+		//empty files are not mapped
+		ifstream fin(fileName.c_str());
+		if(!fin) return false;
+		fileSim(fin);
+		return true;
 	}
-	SortFEC(false);
+	PatternSource src(buf,buf+len);
+	simPatterns(src);
+	munmap((void*)buf,len);
+	return true;
 }
 
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
-//generate 64 signals
-void
-CirMgr::randSig()
+//64 patterns of PI i, biased ones take |bias| extra words: 3/4, 7/8 or
+//15/16 of the bits go to the favored value
+size_t
+CirMgr::piWord(int i, bool biased)
 {
-	_sigList.clear();
-	size_t randint;
-	for(int i=0;i<2;i++){
-		for(int j=0;j<_piList.size();j++){
-			//1st gernerated pattern will be leftmost bit of signal 
-			randint = rnGen(INT_MAX);
-
-			if(i==0) _sigList.push_back(randint);
-			else
-				_sigList[j] = (_sigList[j]<<32) + randint;
-		}
-	}	
+	size_t x = _rng();
+	if(!biased) return x;
+	int b = _piBias[i];
+	for(int t=0;t<b;t++) x |= _rng();
+	for(int t=0;t>b;t--) x &= _rng();
+	return x;
 }
-int
-CirMgr::readSig(ifstream& fin)
+//gates still grouped with CONST0 never toggled. Each is backtraced with
+//the value it never took, AND=1 needs both fanins and AND=0 a random one,
+//and the PIs reached vote once per target for the bias toward that value.
+//A PI every target agrees on gets the strongest bias
+void
+CirMgr::learnBias()
 {
-
-	_sigList.clear();
-	int ofst=0; bool finish=false; int num=0;
-	string pat;
-	while(true){
-		for(int i=0;i<64;i++){
-			if(fin>>pat){
-				if(pat.length() !=_piList.size()){
-					cerr<<"Error: Pattern("<<pat<<") length("<<pat.length();
-					cerr<<") does not match the number of inputs("<<_piList.size();
-					cerr<<") in a circuit!!"<<endl;
-					_fecGrps.clear();
-					return 0;
-				}
-				for(int j=0;j<pat.length();j++){
-					if(pat[j]!='0' && pat[j]!='1'){
-						cerr<<"Error: Pattern("<<pat;
-						cerr<<") contains a non-0/1 character(\'"<<pat[j]<<"\')."<<endl;
-						_fecGrps.clear();
-						return 0;
-					}
-					//1st readed pattern will be leftmost bit of signal 
-					if(i==0) 
-						_sigList.push_back( (size_t)(pat[j]-'0') );
-					else
-						_sigList[ofst+j]=(_sigList[ofst+j]<<1)+ (size_t)(pat[j]-'0');
-				}
-				num++;
+	vector<int> vote(_aig.size(),0);
+	vector<int> seen(_aig.size(),0); //last target that reached the gate
+	vector<pair<unsigned,bool> > stack;
+	size_t g=0;
+	for(;g<_fec.size();g++){
+		unsigned j=0;
+		for(;j<_fec.grpSize(g) && _fec.lit(g,j)/2!=0;j++) ;
+		if(j<_fec.grpSize(g)) break;
+	}
+	int targets=0;
+	for(unsigned j=0;g<_fec.size() && j<_fec.grpSize(g);j++){
+		unsigned l = _fec.lit(g,j);
+		if(l/2==0) continue;
+		targets++;
+		stack.push_back(make_pair(l/2,!(l&1)));
+		while(!stack.empty()){
+			unsigned id = stack.back().first; bool want = stack.back().second;
+			stack.pop_back();
+			if(seen[id]==targets) continue;
+			seen[id]=targets;
+			if(_aig.type(id)==PI_GATE) vote[id] += want ? 1 : -1;
+			if(_aig.type(id)!=AIG_GATE) continue;
+			unsigned f0 = _aig.fanin(id,0), f1 = _aig.fanin(id,1);
+			if(want){
+				stack.push_back(make_pair(f0/2,!(f0&1)));
+				stack.push_back(make_pair(f1/2,!(f1&1)));
 			}
-			else{
-				finish=true;
-				if(i==0) break;
-				for(int j=0;j<_piList.size();j++)
-					_sigList[ofst+j]=(_sigList[ofst+j]<<1) + (size_t)(0);	
+			else {
+				unsigned f = (_rng()&1) ? f1 : f0;
+				stack.push_back(make_pair(f/2,bool(f&1)));
 			}
 		}
-		if(finish) break;
-		ofst+=_piList.size();
 	}
-	return num;
+	for(int i=0;i<_piList.size();i++){
+		int v = vote[_piList[i]->getID()];
+		int s = v ? min(1+2*abs(v)/targets,3) : 0;
+		assert(!v || abs(v)<targets || s==3);
+		_piBias[i] = v>0 ? s : (v<0 ? -s : 0);
+	}
 }
+//fileSim core, patterns are streamed in blocks of 64*W so memory does
+//not grow with the file. The whole input is checked first, so a
+//malformed pattern leaves nothing simulated or logged. With more than
+//one thread the next block is parsed while the current one is simulated.
 void
-CirMgr::simulate()
+CirMgr::simPatterns(PatternSource &src)
 {
-	int id0,id1;
-	bool ph0,ph1;
-	size_t w0,w1;
-	_gateList[0]->setSignal(0);
-	for(int i=0;i<_dfsList.size();i++){
-		CirGate *g = _dfsList[i];
-		if(g->getType()==AIG_GATE){
-			id0 = g->getFaninGateID(0); ph0 = g->getFaninGatePhase(0);
-			id1 = g->getFaninGateID(1); ph1 = g->getFaninGatePhase(1);
-			w0 = _gateList[id0]->getSignal(ph0);
-			w1 = _gateList[id1]->getSignal(ph1);
-			g->setSignal(w0&w1);
+	CreateFirstFEC();
+	size_t n = _piList.size();
+	unsigned W = _aig.words();
+	PatternBlock blk[2];
+	int num=0, b=0;
+	bool ok = blk[0].check(src,n);
+	if(ok && !src.rewind()){
+		blk[0].err = "Error: cannot rewind the pattern file!!";
+		ok = false;
+	}
+	if(ok) ok = blk[0].read(src,n,W);
+	while(ok && blk[b].num>0){
+		PatternBlock &cur = blk[b], &nxt = blk[b^1];
+		bool nxtOk = true;
+		auto simBlock = [&](){
+			unsigned nw = (cur.num+63)/64;
+			for(size_t j=0;j<n;j++)
+				for(unsigned w=0;w<nw;w++)
+					_aig.setSig(_piList[j]->getID(),cur.word[j*W+w],w);
+			simulate(nw); //simulate cur.num pattern
+			int left = cur.num;
+			for(unsigned w=0;w<nw;w++){
+				if(_simLog!=NULL) writeSim(min(left,64),w); //write 64 pattern
+				IdentifyFEC(w);
+				left-=64;
+			}
+		};
+		if(_numThreads>1){
+			parallelRun(2,[&](int t){
+				if(t==0) simBlock();
+				else nxtOk = nxt.read(src,n,W);
+			});
 		}
-		else if(g->getType()==PO_GATE){
-			id0 = g->getFaninGateID(0); ph0 = g->getFaninGatePhase(0);
-			w0 = _gateList[id0]->getSignal(ph0);
-			g->setSignal(w0);
+		else{
+			simBlock();
+			nxtOk = nxt.read(src,n,W);
 		}
-		else if(g->getType()==UNDEF_GATE)
-			g->setSignal(0);
+		num+=cur.num;
+		ok = nxtOk;
+		b^=1;
+	}
+	if(!ok){
+		cerr<<blk[b].err<<endl;
+		_fec.clear();
+		num=0;
+	}
+	_log.flush();
+	cout<<num<<" patterns simulated."<<endl;
+	SortFEC(false);
+}
+//in cone mode only the fanin cones of the FEC candidates are evaluated,
+//the cached cone is rebuilt once the candidates shrank by 1/8, or if
+//they grew past it. POs are needed for the log, so logging simulates
+//everything.
+void
+CirMgr::simulate(unsigned nw)
+{
+	bool cone = _coneSim && _simLog==NULL && !_fec.empty();
+	if(cone && (!_aig.hasActive() || _coneLits < _fec.numLits() ||
+		8*_fec.numLits() < 7*_coneLits)){
+		IdList roots;
+		for(size_t g=0;g<_fec.size();g++)
+			for(unsigned j=0;j<_fec.grpSize(g);j++)
+				roots.push_back(_fec.lit(g,j)/2);
+		_aig.setActive(roots);
+		_coneLits = _fec.numLits();
+	}
+	_aig.simulate(nw,_numThreads,false,cone);
+}
+//word 0 of the PIs becomes _sigList, only the changed fanout cones are
+//re-evaluated and only FEC groups holding a changed gate are refined.
+//Falls back to a full pass when most PIs changed.
+bool
+CirMgr::resimulate()
+{
+	assert(_sigList.size()==_piList.size());
+	IdList pis, changed;
+	size_t diff=0;
+	for(int i=0;i<_piList.size();i++){
+		pis.push_back(_piList[i]->getID());
+		if(_aig.sig(pis[i])!=_sigList[i]) diff++;
+	}
+	if(4*diff > _piList.size()){
+		for(int i=0;i<_piList.size();i++)
+			_aig.setSig(pis[i],_sigList[i]);
+		simulate(1);
+		return IdentifyFEC();
+	}
+	_aig.resimulate(_fanout,pis,_sigList,changed);
+	return IdentifyFEC(changed);
+}
+//lines are buffered, and written by a background thread when threads
+//are available
+void
+CirMgr::setSimLog(ofstream *logFile)
+{
+	_simLog = logFile;
+	_log.open(logFile,_numThreads>1);
+}
+void
+CirMgr::setSimWords(unsigned nw)
+{
+	_aig.setWords(nw<1 ? 1 : nw);
+}
+//patterns per second of the 1-word scalar loop vs. the full-width kernel
+//on 1 to _numThreads threads, then the log writer against the last
+//one. PI words are randomized so current signatures are overwritten
+void
+CirMgr::printSimSpeed(unsigned rounds)
+{
+	unsigned W = _aig.words();
+	for(int i=0;i<_piList.size();i++){
+		for(unsigned w=0;w<W;w++)
+			_aig.setSig(_piList[i]->getID(),_rng(),w);
+	}
+	cout<<"Simulation speed"<<endl;
+	cout<<"=================="<<endl;
+	double simSec = 0;
+	for(int T=0;T<=_numThreads;T=(T ? 2*T : 1)){
+		//T==0 is the scalar reference
+		unsigned nw = (T==0 ? 1 : W);
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		for(unsigned r=0;r<rounds;r++)
+			_aig.simulate(nw,max(T,1),T==0);
+		double sec = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+		double pps = double(rounds)*64*nw/(sec>0 ? sec : 1e-9);
+		cout<<"  "<<left<<setw(7)<<(T==0 ? "scalar" : CirAig::kernelName())
+			<<right<<"x"<<setw(5)<<nw<<setw(4)<<max(T,1)<<" thd"
+			<<setw(12)<<size_t(pps)<<" patterns/s"<<endl;
+		if(T && T<_numThreads && 2*T>_numThreads) T = _numThreads/2;
+		simSec = sec;
 	}
+	//log formatting of the same patterns into a discarding stream
+	ostream nullOs(NULL);
+	CirSimLog log;
+	log.open(&nullOs,_numThreads>1);
+	IdList pi, po;
+	for(int j=0;j<_piList.size();j++) pi.push_back(_piList[j]->getID());
+	for(int j=0;j<_poList.size();j++) po.push_back(_poList[j]->getID());
+	chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	for(unsigned r=0;r<rounds;r++)
+		for(unsigned w=0;w<W;w++) log.write(_aig,pi,po,64,w);
+	log.close();
+	double sec = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+	double pps = double(rounds)*64*W/(sec>0 ? sec : 1e-9);
+	cout<<"  "<<left<<setw(7)<<"log"<<right<<"x"<<setw(5)<<W
+		<<setw(4)<<(_numThreads>1 ? 2 : 1)<<" thd"
+		<<setw(12)<<size_t(pps)<<" patterns/s"
+		<<" ("<<fixed<<setprecision(1)<<100*sec/(simSec>0 ? simSec : 1e-9)
+		<<"% of simulation)"<<defaultfloat<<endl;
 }
 void
 CirMgr::CreateFirstFEC()
 {
-	for(int i=0;i<_fecGrps.size();i++)
-		delete _fecGrps[i];
-	_fecGrps.clear();
-	FECgroup *fgp = new FECgroup;
 	//put all signal in one FECgroup
 	//only AIG_GATE & CONST_GATE in FECgroup
-	fgp->push_back(0);
+	IdList lits(1,0);
 	for(int i=0;i<_dfsList.size();i++){
 		CirGate *g = _dfsList[i];
 		if(g->getType()==AIG_GATE)
-			fgp->push_back(g->getID()*2);
+			lits.push_back(g->getID()*2);
 	}
-	//add it into _fecGrps
-	_fecGrps.push_back(fgp);
+	_fec.init(lits);
+	//the cone of the old candidates is stale
+	_aig.clearActive();
+	_coneLits = 0;
 }
+//refine FEC groups with word w of the signatures
 bool
-CirMgr::IdentifyFEC()
+CirMgr::IdentifyFEC(unsigned w)
 {
-	bool IdtfyNew=false;
-	bool changed=false;
-	for(int i=0;i<_fecGrps.size();i++){
-		unordered_map<size_t,FECgroup*> newFecGrps;
-		FECgroup *fecGrp=_fecGrps[i];
-		changed=false;
-		for(int j=0;j<fecGrp->size();j++){
-			int id = fecGrp->at(j)/2; bool phase = fecGrp->at(j)%2;
-			CirGate *g = _gateList[id];
-			if(newFecGrps.find(g->getSignal(0))!=newFecGrps.end()){
-				FECgroup *grp=newFecGrps[g->getSignal(0)];
-				grp->push_back(id*2+(phase!=0));
-				if(phase!=0) changed=true; //phase changed
-			}
-			else if(newFecGrps.find(g->getSignal(1))!=newFecGrps.end()){
-				FECgroup *grp=newFecGrps[g->getSignal(1)];
-				grp->push_back(id*2+(phase!=1));
-				if(phase!=1) changed=true; //phase changed
-			}
-			else {
-				FECgroup *newgrp = new FECgroup;
-				newgrp->push_back(id*2+phase);
-				newFecGrps[g->getSignal(phase)] = newgrp;
-			}
-		}
-		if((changed && newFecGrps.size()==1)|| newFecGrps.size()>1 ){ 
-			IdtfyNew=true;//identify new FECgroup
-			delete _fecGrps[i];
-			_fecGrps.erase(_fecGrps.begin()+i);i--;
-		
-			unordered_map<size_t,FECgroup*>::iterator it=newFecGrps.begin();
-			for(;it!=newFecGrps.end();++it){
-				if(it->second->size()>1)
-					_fecGrps.push_back(it->second);
-				//else singleton
-			}
-		}
-	}
-	return IdtfyNew;
+	return _fec.refine(_aig,w);
 }
-
-void
-CirMgr::writeSim(int num)
+//refine (word 0) only the groups with a member in changed. _fecMark is
+//kept all 0 between calls, so only the changed entries are touched.
+bool
+CirMgr::IdentifyFEC(const IdList &changed)
 {
-	string pat,result;
-	for(int i=63;i>=0;i--){
-		//1st pattern will be leftmost bit of signal
-		pat.clear();result.clear();
-		for(int j=0;j<_piList.size();j++){
-			size_t bit = ((size_t)(1)<<i) & (_piList[j]->getSignal(0));
-			bit = bit>>i;
-			pat+= ('0'+bit);
-		}
-		for(int j=0;j<_poList.size();j++){
-			size_t bit = ((size_t)(1)<<i) & (_poList[j]->getSignal(0));
-			bit = bit>>i;
-			result+= ('0'+bit);
-		}
-		if(num>0) (*_simLog)<<pat<<" "<<result<<endl;
-		else break;
-		num--;
-	}
+	if(_fecMark.size()<_gateList.size()) _fecMark.resize(_gateList.size(),0);
+	for(size_t i=0;i<changed.size();i++) _fecMark[changed[i]]=1;
+	bool split = _fec.refine(_aig,0,&_fecMark);
+	for(size_t i=0;i<changed.size();i++) _fecMark[changed[i]]=0;
+	return split;
 }
 
+//log num patterns of word w, 1st pattern is the leftmost bit
 void
-CirMgr::setFirstFgp() const {
-	//Reset all gate's _fgp
-	for(int i=0;i<_gateList.size();i++){
-		if(_gateList[i]!=NULL)
-			_gateList[i]->setFgp(NULL);
-	}
-	for(int i=0;i<_fecGrps.size();i++){
-		FECgroup *grp = _fecGrps[i];
-		int firstID = grp->at(0)/2;
-		_gateList[firstID]->setFgp(grp);
-	}
+CirMgr::writeSim(int num, unsigned w)
+{
+	IdList pi, po;
+	for(int j=0;j<_piList.size();j++) pi.push_back(_piList[j]->getID());
+	for(int j=0;j<_poList.size();j++) po.push_back(_poList[j]->getID());
+	_log.write(_aig,pi,po,num,w);
 }
+
 void
 CirMgr::SortFEC(bool dfs){
-	//sort each vector
-	for(int i=0;i<_fecGrps.size();i++){
-		if(_fecGrps[i]->size()<=1){
-			delete _fecGrps[i];
-			_fecGrps.erase(_fecGrps.begin()+i);i--;
-			continue;
-		}
-		if(!dfs) 
-			sort(_fecGrps[i]->begin(),_fecGrps[i]->end()); 
-		else sort(_fecGrps[i]->begin(),_fecGrps[i]->end(),FecGrpSort());
+	//sort each group
+	if(!dfs) _fec.sortLits(less<unsigned>());
+	else {
+		_fec.sortLits(FecGrpSort());
+		_fec.sortGroups();
 	}
-	if(dfs) sort(_fecGrps.begin(),_fecGrps.end(),FecListSort());
 }
+//drop gates that were removed or left the dfs list, CONST0 stays even
+//when unreachable
 void
 CirMgr::resetFEC(){
-	for(int i=_fecGrps.size()-1;i>=0;i--){
-		FECgroup *grp = _fecGrps[i];
-		int id; 
-		for(int j=grp->size()-1;j>=0;j--){
-			id = grp->at(j)/2;
-			if(_gateList[id]==NULL || _gateList[id]->getDfsNum()==-1){
-				grp->erase(grp->begin()+j);
-			}
-			if(grp->size()==1){
-				delete _fecGrps[i];
-				_fecGrps.erase(_fecGrps.begin()+i);
-				break;
-			}
-		}
-	}
+	_fec.filter([this](unsigned lit){
+		CirGate *g = _gateList[lit/2];
+		return lit/2==0 || (g!=NULL && g->getDfsNum()!=-1);
+	});
 }
@@ -0,0 +1,147 @@
+/****************************************************************************
+  FileName     [ cirSimLog.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define buffered simulation log writer functions ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include "cirSimLog.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+//buffer size that triggers a write
+static const size_t LOG_BUF_SIZE = 1<<20;
+
+//byte b as 8 '0'/'1' chars in memory order, bit 0 first
+struct CharTable
+{
+	CharTable(){
+		for(unsigned b=0;b<256;b++){
+			char c[8];
+			for(int i=0;i<8;i++) c[i] = '0'+((b>>i)&1);
+			memcpy(&chars[b],c,8);
+		}
+	}
+	size_t chars[256];
+};
+static const CharTable charTable;
+
+/**************************************/
+/*   class CirSimLog member functions */
+/**************************************/
+void
+CirSimLog::open(ostream *os, bool async)
+{
+	close();
+	_os = os; _async = async;
+	_buf.clear(); _buf.reserve(LOG_BUF_SIZE+(1<<16));
+	if(_os!=NULL && _async){
+		_stop = false; _busy = false;
+		_thread = thread(&CirSimLog::writer,this);
+	}
+}
+void
+CirSimLog::close()
+{
+	if(_os==NULL) return;
+	//the stream may be gone by now if nothing is left to write
+	if(!_buf.empty()) flush();
+	if(_thread.joinable()){
+		{
+			lock_guard<mutex> lk(_mtx);
+			_stop = true;
+		}
+		_cv.notify_all();
+		_thread.join();
+	}
+	_os = NULL;
+}
+void
+CirSimLog::write(const CirAig &aig, const IdList &pi, const IdList &po,
+	int num, unsigned w)
+{
+	if(_os==NULL || num<=0) return;
+	if(num>64) num=64;
+	size_t lineLen = pi.size()+po.size()+2;
+	size_t base = _buf.size();
+	_buf.resize(base+num*lineLen);
+	putWords(aig,pi,w,num,base,lineLen);
+	putWords(aig,po,w,num,base+pi.size()+1,lineLen);
+	for(int p=0;p<num;p++){
+		_buf[base+p*lineLen+pi.size()] = ' ';
+		_buf[base+(p+1)*lineLen-1] = '\n';
+	}
+	if(_buf.size()>=LOG_BUF_SIZE) handOff();
+}
+//column block of the lines: 64 gates transposed into 64 pattern rows
+void
+CirSimLog::putWords(const CirAig &aig, const IdList &ids, unsigned w,
+	int num, size_t ofst, size_t lineLen)
+{
+	size_t a[64];
+	for(size_t c=0;c<ids.size();c+=64){
+		size_t k = min(ids.size()-c,size_t(64));
+		for(size_t i=0;i<64;i++) a[i] = i<k ? aig.sig(ids[c+i],w) : 0;
+		transpose64(a);
+		//pattern p is bit 63-p of a signature, now row 63-p
+		for(int p=0;p<num;p++){
+			char *dst = &_buf[ofst+p*lineLen+c];
+			size_t row = a[63-p];
+			size_t i=0;
+			for(;i+8<=k;i+=8)
+				memcpy(dst+i,&charTable.chars[(row>>i)&255],8);
+			if(i<k) memcpy(dst+i,&charTable.chars[(row>>i)&255],k-i);
+		}
+	}
+}
+//push the filled buffer out, waits for the previous one in async mode
+void
+CirSimLog::handOff()
+{
+	if(_buf.empty()) return;
+	if(!_async){
+		_os->write(&_buf[0],_buf.size());
+		_buf.clear();
+		return;
+	}
+	unique_lock<mutex> lk(_mtx);
+	_cv.wait(lk,[this]{ return !_busy; });
+	_pending.swap(_buf);
+	_busy = true;
+	lk.unlock();
+	_cv.notify_all();
+	_buf.clear();
+}
+void
+CirSimLog::flush()
+{
+	if(_os==NULL) return;
+	handOff();
+	if(_async){
+		unique_lock<mutex> lk(_mtx);
+		_cv.wait(lk,[this]{ return !_busy; });
+	}
+	_os->flush();
+}
+void
+CirSimLog::writer()
+{
+	unique_lock<mutex> lk(_mtx);
+	while(true){
+		_cv.wait(lk,[this]{ return _busy || _stop; });
+		if(!_busy) return; //stopped with nothing pending
+		lk.unlock();
+		_os->write(&_pending[0],_pending.size());
+		_pending.clear();
+		lk.lock();
+		_busy = false;
+		_cv.notify_all();
+	}
+}
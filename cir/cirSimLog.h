@@ -0,0 +1,62 @@
+/****************************************************************************
+  FileName     [ cirSimLog.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define buffered simulation log writer ]
+  Author       [ Yun-Rong Luo, Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SIM_LOG_H
+#define CIR_SIM_LOG_H
+
+#include <vector>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cirDef.h"
+#include "cirAig.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   Define classes
+//------------------------------------------------------------------------
+// Writes "<PI pattern> <PO values>" lines of simulated words. PI/PO words
+// are bit-transposed 64 gates at a time and the characters are placed
+// straight into a large buffer, which goes to the stream in one write()
+// once it is full. With async the full buffer is handed to a writer
+// thread and filling continues in a second buffer.
+class CirSimLog
+{
+public:
+   CirSimLog(): _os(NULL), _async(false), _busy(false), _stop(false) {}
+   ~CirSimLog() { close(); }
+
+   void open(ostream *os, bool async=false);
+   void close();
+   bool isOpen() const { return _os!=NULL; }
+
+   //log the first num patterns of word w, 1st pattern is the leftmost bit
+   void write(const CirAig &aig, const IdList &pi, const IdList &po,
+		int num, unsigned w=0);
+   //everything written so far is in the stream
+   void flush();
+
+private:
+   void putWords(const CirAig &aig, const IdList &ids, unsigned w,
+		int num, size_t ofst, size_t lineLen);
+   void handOff();
+   void writer();
+
+   ostream                *_os;
+   bool                    _async;
+   vector<char>            _buf;     //being filled
+   vector<char>            _pending; //being written by _thread
+   bool                    _busy, _stop;
+   thread                  _thread;
+   mutex                   _mtx;
+   condition_variable      _cv;
+};
+
+#endif // CIR_SIM_LOG_H